@@ -0,0 +1,211 @@
+
+// SoA against AoS vertex fetch for position + normal + uv meshes
+// The CPU walks the index buffer the way the vertex fetch unit does, reading every attribute of each referenced vertex
+// Reported: best wall time over the runs, and misses of a simulated 32 KiB direct mapped cache with 64 byte lines
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "server/vertex.hpp"
+#include "server/mesh_optimizer.hpp"
+
+static constexpr uint32_t LINE_SIZE = 64;
+static constexpr uint32_t CACHE_LINES = 32 * 1024 / LINE_SIZE;
+
+struct SoAMesh {
+    std::vector<vec3> positions;
+    std::vector<vec3> normals;
+    std::vector<vec2> uvs;
+};
+
+struct AoSMesh {
+    std::vector<PositionNormalUvVertex> vertices;
+};
+
+struct Grid {
+    SoAMesh soa;
+    AoSMesh aos;
+    std::vector<uint32_t> indices;
+    uint32_t vertex_count = 0;
+};
+
+// Direct mapped, enough to compare how many distinct lines each layout drags in
+struct CacheModel {
+    std::vector<uintptr_t> tags = std::vector<uintptr_t>(CACHE_LINES, UINTPTR_MAX);
+    uint64_t misses = 0;
+
+    void touch(const void *address, uint32_t size) {
+        uintptr_t first = reinterpret_cast<uintptr_t>(address) / LINE_SIZE;
+        uintptr_t last = (reinterpret_cast<uintptr_t>(address) + size - 1) / LINE_SIZE;
+        for (uintptr_t line = first; line <= last; ++line) {
+            uintptr_t &tag = tags[line % CACHE_LINES];
+            if (tag != line) {
+                tag = line;
+                misses++;
+            }
+        }
+    }
+};
+
+static Grid make_grid(uint32_t side) {
+    Grid grid;
+    grid.vertex_count = side * side;
+
+    grid.soa.positions.resize(grid.vertex_count);
+    grid.soa.normals.resize(grid.vertex_count);
+    grid.soa.uvs.resize(grid.vertex_count);
+    for (uint32_t y = 0; y < side; ++y) {
+        for (uint32_t x = 0; x < side; ++x) {
+            uint32_t vertex = y * side + x;
+            float u = static_cast<float>(x) / (side - 1);
+            float v = static_cast<float>(y) / (side - 1);
+            grid.soa.positions[vertex] = vec3(u, std::sin(u * 6.0f) * std::cos(v * 6.0f), v);
+            grid.soa.normals[vertex] = vec3(0.0f, 1.0f, 0.0f);
+            grid.soa.uvs[vertex] = vec2(u, v);
+        }
+    }
+
+    grid.aos.vertices.resize(grid.vertex_count);
+    for (uint32_t vertex = 0; vertex < grid.vertex_count; ++vertex) {
+        PositionNormalUvVertex::Attributes::gather(grid.aos.vertices[vertex], vertex,
+            grid.soa.positions.data(), grid.soa.normals.data(), grid.soa.uvs.data());
+    }
+
+    for (uint32_t y = 0; y + 1 < side; ++y) {
+        for (uint32_t x = 0; x + 1 < side; ++x) {
+            uint32_t corner = y * side + x;
+            grid.indices.insert(grid.indices.end(), {corner, corner + side, corner + 1, corner + 1, corner + side, corner + side + 1});
+        }
+    }
+    return grid;
+}
+
+// Random triangle order, what an unprocessed exported mesh looks like at worst
+static void shuffle_triangles(std::vector<uint32_t> &indices) {
+    std::vector<uint32_t> triangles(indices.size() / 3);
+    std::iota(triangles.begin(), triangles.end(), 0u);
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(42));
+
+    std::vector<uint32_t> shuffled;
+    shuffled.reserve(indices.size());
+    for (uint32_t triangle : triangles) {
+        shuffled.insert(shuffled.end(), indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3);
+    }
+    indices = std::move(shuffled);
+}
+
+// Same passes as MeshBuilder::set_optimized, the vertices of both layouts are moved in fetch order
+static void optimize(Grid &grid) {
+    optimize_vertex_cache(grid.indices, grid.vertex_count);
+
+    std::vector<uint32_t> order;
+    optimize_vertex_fetch(grid.indices, grid.vertex_count, order);
+
+    SoAMesh soa;
+    AoSMesh aos;
+    for (uint32_t old_vertex : order) {
+        soa.positions.push_back(grid.soa.positions[old_vertex]);
+        soa.normals.push_back(grid.soa.normals[old_vertex]);
+        soa.uvs.push_back(grid.soa.uvs[old_vertex]);
+        aos.vertices.push_back(grid.aos.vertices[old_vertex]);
+    }
+    grid.soa = std::move(soa);
+    grid.aos = std::move(aos);
+    grid.vertex_count = static_cast<uint32_t>(order.size());
+}
+
+static float fetch_soa(const Grid &grid) {
+    float sum = 0.0f;
+    for (uint32_t index : grid.indices) {
+        const vec3 &position = grid.soa.positions[index];
+        const vec3 &normal = grid.soa.normals[index];
+        const vec2 &uv = grid.soa.uvs[index];
+        sum += position.x + position.y + position.z + normal.x + normal.y + normal.z + uv.x + uv.y;
+    }
+    return sum;
+}
+
+static float fetch_aos(const Grid &grid) {
+    float sum = 0.0f;
+    for (uint32_t index : grid.indices) {
+        const PositionNormalUvVertex &vertex = grid.aos.vertices[index];
+        sum += vertex.position.x + vertex.position.y + vertex.position.z + vertex.normal.x + vertex.normal.y + vertex.normal.z + vertex.uv.x + vertex.uv.y;
+    }
+    return sum;
+}
+
+static uint64_t misses_soa(const Grid &grid) {
+    CacheModel cache;
+    for (uint32_t index : grid.indices) {
+        cache.touch(&grid.soa.positions[index], sizeof(vec3));
+        cache.touch(&grid.soa.normals[index], sizeof(vec3));
+        cache.touch(&grid.soa.uvs[index], sizeof(vec2));
+    }
+    return cache.misses;
+}
+
+static uint64_t misses_aos(const Grid &grid) {
+    CacheModel cache;
+    for (uint32_t index : grid.indices) {
+        cache.touch(&grid.aos.vertices[index], sizeof(PositionNormalUvVertex));
+    }
+    return cache.misses;
+}
+
+template <typename F>
+static double best_time(F &&fetch, const Grid &grid, uint32_t runs, volatile float &sink) {
+    double best = 1e30;
+    for (uint32_t run = 0; run < runs; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        sink = sink + fetch(grid);
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    return best;
+}
+
+static void report(const char *order, const Grid &grid, uint32_t runs) {
+    volatile float sink = 0.0f;
+    double fetches = static_cast<double>(grid.indices.size());
+
+    double soa_time = best_time(fetch_soa, grid, runs, sink) / fetches;
+    double aos_time = best_time(fetch_aos, grid, runs, sink) / fetches;
+    double soa_misses = misses_soa(grid) / fetches;
+    double aos_misses = misses_aos(grid) / fetches;
+
+    std::cout << std::left << std::setw(12) << order << std::right << std::fixed
+              << std::setw(12) << std::setprecision(2) << soa_time
+              << std::setw(12) << std::setprecision(2) << aos_time
+              << std::setw(14) << std::setprecision(3) << soa_misses
+              << std::setw(14) << std::setprecision(3) << aos_misses << std::endl;
+}
+
+int main(int argc, char **argv) {
+    uint32_t side = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 1024; // Vertices per grid side
+    uint32_t runs = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 10;
+    side = std::max(side, 2u);
+    runs = std::max(runs, 1u);
+
+    std::cout << side * side << " vertices, " << sizeof(PositionNormalUvVertex) << " byte interleaved stride, best of " << runs << " runs" << std::endl;
+    std::cout << std::left << std::setw(12) << "order" << std::right
+              << std::setw(12) << "SoA ns/idx" << std::setw(12) << "AoS ns/idx"
+              << std::setw(14) << "SoA miss/idx" << std::setw(14) << "AoS miss/idx" << std::endl;
+
+    Grid grid = make_grid(side);
+    report("generated", grid, runs);
+
+    shuffle_triangles(grid.indices);
+    report("shuffled", grid, runs);
+
+    optimize(grid);
+    report("optimized", grid, runs);
+    return 0;
+}
@@ -2,6 +2,7 @@
 #ifndef ALCHEMIST_EDITOR_GLOBAL_HPP
 #define ALCHEMIST_EDITOR_GLOBAL_HPP
 
+#include <deque>
 #include <memory>
 
 #define GLFW_INCLUDE_VULKAN
@@ -16,6 +17,17 @@
 
 #include "vulkan/sync.hpp"
 #include "vulkan/command_buffer.hpp"
+#include "vulkan/recorder.hpp"
+#include "vulkan/parallel_recorder.hpp"
+
+struct SwapchainGarbage {
+    RetiredSwapchain swapchain; // Replaced swapchain with its images and views
+    std::vector<RID> framebuffers; // Scene and ImGui framebuffers of the replaced swapchain
+    RID depth_image = RID_INVALID;
+    RID depth_memory = RID_INVALID;
+    RID depth_view = RID_INVALID;
+    uint64_t retire_frame = 0; // Frames submitted before the swapchain was replaced
+};
 
 struct Global {
     EditorCamera camera = EditorCamera(vec3(1.0f, 1.0f, 1.0f), vec3(0.0f), 5.0f);
@@ -28,15 +40,23 @@ struct Global {
     RenderingDevice rendering_device; // Pointer to the rendering device
 
     uint32_t flight_frame = 0;
+    uint32_t frames_in_flight = 2; // Number of frames recorded ahead of the GPU
+    uint64_t frame_count = 0; // Frames submitted so far
+
+    std::deque<SwapchainGarbage> swapchain_garbage; // Swapchain resources waiting for the frames using them to retire
 
-    std::vector<CommandBuffer> command_buffers;
-    std::vector<CommandBuffer> gui_command_buffers;
+    std::vector<CommandBuffer> command_buffers; // Scene commands of each frame in flight
+    std::vector<CommandBuffer> gui_command_buffers; // ImGui commands of each frame in flight
     std::vector<Fence> fences;
     std::vector<Semaphore> image_semaphores;
     std::vector<Semaphore> render_semaphores;
 
-    RID command_pool;
-    RID gui_command_pool;
+    CommandRecorder recorder; // Drops redundant binds in the frame command buffer, its stats cover the last recorded frame
+    std::unique_ptr<ParallelRecorder> parallel_recorder; // Records large passes as secondary buffers on worker threads
+
+    std::vector<RID> frame_command_pools; // Transient pool of each frame in flight
+    RID transfer_command_pool;
+    RID compute_command_pool;
 
     RID render_pass;
     RID gui_render_pass;
@@ -61,6 +81,8 @@ struct Global {
 
     RID graphic_queue;
     RID present_queue;
+    RID transfer_queue;
+    RID compute_queue; // Async compute queue, the graphics queue when async compute is off or unavailable
 
     RID depth_image;
     RID depth_memory;
@@ -71,6 +93,11 @@ struct Global {
 
     Global() = default;
     void init(const ApplicationInfo &info);
+
+    void create_swapchain_resources(); // Depth buffer and framebuffers sized from the swapchain
+    bool recreate_swapchain(); // False if the window is minimized
+    void begin_frame_commands(); // Reset the pool of the current frame and hand out its command buffers, its fence must have signaled
+    void collect_swapchain_garbage(bool force = false); // Destroy the retired swapchain resources no frame uses anymore, force once the device is idle
     ~Global();
 
     static Global &instance();
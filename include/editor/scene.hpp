@@ -4,6 +4,8 @@
 
 #include <vulkan/vulkan.h>
 
+#include "vulkan/recorder.hpp"
+
 struct Scene {
     bool in_transition = false; // Flag to indicate if the scene is in transition
     bool in_editor = false; // Flag to indicate if the scene is in editor mode
@@ -13,7 +15,7 @@ struct Scene {
     virtual void enter() = 0;
     virtual void exit() = 0;
     virtual void update(float delta_time) = 0;
-    virtual void render(VkCommandBuffer command_buffer, uint32_t image_index) = 0;
+    virtual void render(CommandRecorder &recorder, uint32_t image_index) = 0;
     virtual void imgui() = 0;
 };
 
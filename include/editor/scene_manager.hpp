@@ -15,6 +15,9 @@
 #include "editor/scene.hpp"
 #include "editor/transition.hpp"
 
+#include "server/transfer.hpp"
+#include "server/deletion.hpp"
+
 struct SceneManager {
     std::unordered_map<std::string, std::unique_ptr<Scene>> scenes;
 
@@ -82,6 +85,13 @@ struct SceneManager {
         Global &global = Global::instance();
 
         global.fences[global.flight_frame].wait();
+        global.parallel_recorder->begin_frame(global.flight_frame); // The secondary buffers of this frame are done
+        DeletionQueue::instance().collect(global.frame_count); // Resources released by the frame that used this fence are unused now
+        global.collect_swapchain_garbage(); // The frames using a replaced swapchain may be done now
+
+        if (global.need_resize && !global.recreate_swapchain()) {
+            return; // Minimized, nothing to render to
+        }
 
         const Queue &graphic_queue = QueueServer::instance().get_queue(global.graphic_queue);
         const Queue &present_queue = QueueServer::instance().get_queue(global.present_queue);
@@ -96,16 +106,32 @@ struct SceneManager {
             &image_index
         );
 
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            global.need_resize = true; // Nothing was acquired, the semaphore stays unsignaled
+            return;
+        }
+        if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            #ifdef ALCHEMIST_DEBUG
+            std::cerr << "Failed to acquire swapchain image: " << result << std::endl;
+            #endif
+            return;
+        }
+
         global.fences[global.flight_frame].reset(); // Reset the fence for the current frame
-        global.command_buffers[global.flight_frame].reset(); // Reset the command buffer for the current frame
+        global.begin_frame_commands(); // Reset the frame pool in one call
 
         global.command_buffers[global.flight_frame].begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        global.recorder.begin(global.command_buffers[global.flight_frame].buffer);
+
+        SubmitBuilder submit = graphic_queue.submit();
+        TransferServer::instance().collect();
+        TransferServer::instance().acquire(global.command_buffers[global.flight_frame].buffer, submit, global.fences[global.flight_frame].fence); // Take ownership of the finished uploads
 
         if (current_scene) {
-            current_scene->render(global.command_buffers[global.flight_frame].buffer, image_index); // Render the current scene
+            current_scene->render(global.recorder, image_index); // Render the current scene
         }
         if (current_transition) {
-            current_transition->render(global.command_buffers[global.flight_frame].buffer); // Render the current transition
+            current_transition->render(global.recorder); // Render the current transition
         }
 
         global.command_buffers[global.flight_frame].end(); // End the command buffer recording
@@ -125,10 +151,10 @@ struct SceneManager {
         ImDrawData* main_draw_data = ImGui::GetDrawData();
         const bool main_is_minimized = (main_draw_data->DisplaySize.x <= 0.0f || main_draw_data->DisplaySize.y <= 0.0f);
 
-        global.gui_command_buffers[image_index].begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        global.gui_command_buffers[global.flight_frame].begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 
         const RenderPass &imgui_render_pass = RenderPassServer::instance().get_render_pass(global.gui_render_pass);
-        auto render_pass = imgui_render_pass.begin(global.gui_command_buffers[image_index].buffer);
+        auto render_pass = imgui_render_pass.begin(global.gui_command_buffers[global.flight_frame].buffer);
         render_pass
             .set_framebuffer(global.gui_framebuffer[image_index])
             .set_render_offset({0, 0})
@@ -136,25 +162,25 @@ struct SceneManager {
             .add_clear_color(BLACK)
             .begin(); // Clear color
 
-        ImGui_ImplVulkan_RenderDrawData(main_draw_data, global.gui_command_buffers[image_index].buffer);
+        ImGui_ImplVulkan_RenderDrawData(main_draw_data, global.gui_command_buffers[global.flight_frame].buffer);
 
         render_pass.end(); // End the render pass
-        global.gui_command_buffers[image_index].end(); // End the command buffer recording
+        global.gui_command_buffers[global.flight_frame].end(); // End the command buffer recording
 
         #endif // ALCHEMIST_DEBUG
 
-        graphic_queue.submit()
+        submit
             .add_command_buffer(global.command_buffers[global.flight_frame])
-            .add_command_buffer(global.gui_command_buffers[image_index]) // Submit ImGui command buffer
+            .add_command_buffer(global.gui_command_buffers[global.flight_frame]) // Submit ImGui command buffer
             .add_wait_semaphore(global.image_semaphores[global.flight_frame].semaphore, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT)
-            .add_signal_semaphore(global.render_semaphores[global.flight_frame].semaphore)
+            .add_signal_semaphore(global.render_semaphores[image_index].semaphore)
             .submit(global.fences[global.flight_frame].fence);
         
         VkPresentInfoKHR presentInfo{};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
         presentInfo.waitSemaphoreCount = 1;
-        presentInfo.pWaitSemaphores = &global.render_semaphores[global.flight_frame].semaphore;
+        presentInfo.pWaitSemaphores = &global.render_semaphores[image_index].semaphore;
 
         VkSwapchainKHR swapChains[] = {global.rendering_device.swapchain};
         presentInfo.swapchainCount = 1;
@@ -163,8 +189,12 @@ struct SceneManager {
         presentInfo.pImageIndices = &image_index;
 
         result = vkQueuePresentKHR(present_queue.queue, &presentInfo);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+            global.need_resize = true; // Recreated at the start of the next frame
+        }
 
-        global.flight_frame = (global.flight_frame + 1) & 1; // Cycle to the next frame
+        global.frame_count++;
+        global.flight_frame = (global.flight_frame + 1) % global.frames_in_flight; // Cycle to the next frame
     }
 
     void imgui() {
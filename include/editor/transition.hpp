@@ -4,13 +4,15 @@
 
 #include <vulkan/vulkan.h>
 
+#include "vulkan/recorder.hpp"
+
 struct Transition {
     bool in_editor = false; // Flag to indicate if the scene is in editor mode
 
     virtual void enter() = 0;
     virtual void exit() = 0;
     virtual void update(float delta_time) = 0;
-    virtual void render(VkCommandBuffer command_buffer) = 0;
+    virtual void render(CommandRecorder &recorder) = 0;
 };
 
 #endif // ALCHEMIST_EDITOR_TRANSITION_HPP
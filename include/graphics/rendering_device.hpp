@@ -29,6 +29,19 @@ struct ApplicationInfo {
 
     QueueFamilyPreferences
         queue_family_preferences; // Preferences for queue families
+
+    uint32_t frames_in_flight = 2; // Frames recorded ahead of the GPU, clamped to [1, MAX_FRAMES_IN_FLIGHT]
+    uint32_t swapchain_images = 0; // Requested swapchain image count, 0 for minImageCount + 1
+    bool async_compute = true; // Submit compute work to a dedicated compute family when the device has one
+};
+
+constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+
+struct RetiredSwapchain {
+    VkSwapchainKHR swapchain = VK_NULL_HANDLE; // Replaced swapchain, destroyed once no frame uses it
+    uint32_t image_count = 0;
+    VkImage *images = nullptr;
+    VkImageView *image_views = nullptr;
 };
 
 struct RenderingDevice {
@@ -55,6 +68,7 @@ struct RenderingDevice {
     VkExtent2D swapchain_extent;
 
     uint32_t swapchain_image_count;
+    uint32_t requested_image_count = 0; // Swapchain image count asked for by the application, 0 for the default
 
     VkImage *swapchain_images;
     VkImageView *swapchain_image_views;
@@ -65,6 +79,12 @@ struct RenderingDevice {
 
     RenderingDevice &operator=(RenderingDevice &&other);
 
+    // Build a new swapchain from the current window size, the old one is handed back to be destroyed later
+    // False if the window is minimized, retired is then empty and the old swapchain stays in use
+    // Also false if the creation failed, the old swapchain is retired anyway and there is no swapchain until the next call
+    bool recreate_swapchain(GLFWwindow *window, RetiredSwapchain &retired);
+    void destroy_swapchain(const RetiredSwapchain &retired) const;
+
     ~RenderingDevice();
 };
 
@@ -0,0 +1,184 @@
+
+#ifndef ALCHEMIST_MEMORY_SLOT_MAP_HPP
+#define ALCHEMIST_MEMORY_SLOT_MAP_HPP
+
+#include <deque>
+#include <vector>
+#include <optional>
+#include <iterator>
+#include <utility>
+
+#include <cstdint>
+
+#include "server/rid.hpp"
+
+// Generational slot map, the RID of an element encodes its slot index, the slot generation and the resource type
+// Lookups are O(1), references stay valid until the element is erased and stale RIDs are rejected
+template <typename T, RID Type>
+struct SlotMap {
+    struct Slot {
+        std::optional<T> value; // Element stored in the slot, empty if the slot is free
+        uint32_t generation = 0; // Bumped every time the slot is freed
+    };
+
+    std::deque<Slot> slots; // Deque so that growing never moves the stored elements
+    std::vector<uint32_t> free_slots; // Indices of the free slots, reused before growing
+
+    size_t count = 0; // Number of live elements
+
+    template <typename... Args>
+    RID emplace(Args &&...args) {
+        uint32_t index;
+        if (!free_slots.empty()) {
+            index = free_slots.back();
+            free_slots.pop_back(); // Reuse a free slot
+        } else {
+            index = slots.size();
+            slots.emplace_back(); // Grow the slot storage
+        }
+
+        Slot &slot = slots[index];
+        slot.value.emplace(std::forward<Args>(args)...); // Construct the element in place
+
+        RID rid = rid_make(Type, slot.generation, index);
+        if constexpr (requires (T &value) { value.rid = RID_INVALID; }) {
+            slot.value->rid = rid; // Stamp the RID on elements that keep track of it
+        }
+
+        count++;
+        return rid;
+    }
+
+    bool erase(RID rid) {
+        Slot *slot = find(rid);
+        if (slot == nullptr) {
+            return false; // Stale or foreign RID, nothing to erase
+        }
+
+        slot->value.reset(); // Destroy the element
+        slot->generation = (slot->generation + 1) & RID_GENERATION_MASK; // Invalidate every RID pointing to this slot
+        free_slots.push_back(rid_index(rid));
+
+        count--;
+        return true;
+    }
+
+    void clear() {
+        slots.clear();
+        free_slots.clear();
+        count = 0;
+    }
+
+    bool contains(RID rid) const {
+        return find(rid) != nullptr;
+    }
+
+    T *get(RID rid) {
+        Slot *slot = find(rid);
+        return slot ? &*slot->value : nullptr; // Null if the RID is stale or invalid
+    }
+
+    const T *get(RID rid) const {
+        const Slot *slot = find(rid);
+        return slot ? &*slot->value : nullptr; // Null if the RID is stale or invalid
+    }
+
+    // Returns a value-initialized element if the RID is stale or invalid, mirrors the old "not found" fallbacks
+    const T &at(RID rid) const {
+        const T *value = get(rid);
+        return value ? *value : sentinel();
+    }
+
+    T &at(RID rid) {
+        T *value = get(rid);
+        if (value) {
+            return *value;
+        }
+        thread_local T invalid{}; // Mutable fallback, one per thread so workers missing at once never share it
+        invalid = T{}; // Reset on every miss so writes through it never stick
+        return invalid;
+    }
+
+    static const T &sentinel() {
+        static const T invalid{}; // Shared invalid element, never stored in a slot
+        return invalid;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    template <typename S, typename V>
+    struct Iterator {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = V *;
+        using reference = V &;
+
+        S it; // Current slot
+        S end; // End of the slot storage
+
+        Iterator(S it, S end) : it(it), end(end) {
+            skip(); // Move to the first live element
+        }
+
+        void skip() {
+            while (it != end && !it->value.has_value()) {
+                ++it;
+            }
+        }
+
+        reference operator*() const { return *it->value; }
+        pointer operator->() const { return &*it->value; }
+
+        Iterator &operator++() {
+            ++it;
+            skip();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        bool operator==(const Iterator &other) const { return it == other.it; }
+    };
+
+    using iterator = Iterator<typename std::deque<Slot>::iterator, T>;
+    using const_iterator = Iterator<typename std::deque<Slot>::const_iterator, const T>;
+
+    iterator begin() { return iterator(slots.begin(), slots.end()); }
+    iterator end() { return iterator(slots.end(), slots.end()); }
+    const_iterator begin() const { return const_iterator(slots.cbegin(), slots.cend()); }
+    const_iterator end() const { return const_iterator(slots.cend(), slots.cend()); }
+
+    Slot *find(RID rid) {
+        return const_cast<Slot *>(std::as_const(*this).find(rid));
+    }
+
+    const Slot *find(RID rid) const {
+        if (rid == RID_INVALID || rid_type(rid) != Type) {
+            return nullptr; // Invalid RID or RID of another resource type
+        }
+
+        uint32_t index = rid_index(rid);
+        if (index >= slots.size()) {
+            return nullptr; // Out of range
+        }
+
+        const Slot &slot = slots[index];
+        if (!slot.value.has_value() || slot.generation != rid_generation(rid)) {
+            return nullptr; // Freed slot or stale handle
+        }
+        return &slot;
+    }
+};
+
+#endif // ALCHEMIST_MEMORY_SLOT_MAP_HPP
@@ -0,0 +1,45 @@
+
+#ifndef ALCHEMIST_MEMORY_STATE_KEY_HPP
+#define ALCHEMIST_MEMORY_STATE_KEY_HPP
+
+#include <string>
+#include <cstring>
+#include <type_traits>
+
+#include <cstdint>
+
+// Canonical byte encoding of a creation state, used as a hash map key to deduplicate Vulkan objects
+// Fields are appended one by one so that struct padding and unused pointers never reach the key
+struct StateKey {
+    std::string bytes; // Encoded state, hashed and compared as a whole
+
+    template <typename T>
+    requires std::is_trivially_copyable_v<T>
+    StateKey &add(const T &value) {
+        bytes.append(reinterpret_cast<const char *>(&value), sizeof(T));
+        return *this;
+    }
+
+    StateKey &add_bytes(const void *data, size_t size) {
+        add(size); // Length prefix, two different splits never encode the same
+        if (size > 0) {
+            bytes.append(static_cast<const char *>(data), size);
+        }
+        return *this;
+    }
+
+    StateKey &add_string(const char *string) {
+        return add_bytes(string, string ? std::strlen(string) : 0);
+    }
+
+    template <typename T>
+    StateKey &add_array(const T *values, uint32_t count) {
+        add(count);
+        for (uint32_t i = 0; values && i < count; ++i) {
+            add(values[i]);
+        }
+        return *this;
+    }
+};
+
+#endif // ALCHEMIST_MEMORY_STATE_KEY_HPP
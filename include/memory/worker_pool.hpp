@@ -0,0 +1,40 @@
+
+#ifndef ALCHEMIST_MEMORY_WORKER_POOL_HPP
+#define ALCHEMIST_MEMORY_WORKER_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+
+// Fixed set of threads draining a FIFO of jobs
+struct WorkerPool {
+    std::vector<std::thread> workers; // Worker threads, joined on destruction
+    std::deque<std::function<void()>> jobs; // Jobs waiting for a worker
+
+    std::mutex mutex; // Guards jobs, active and stopping
+    std::condition_variable wake; // Signaled when a job is queued or the pool stops
+    std::condition_variable idle; // Signaled when the last running job finishes
+
+    uint32_t active = 0; // Jobs currently running
+    bool stopping = false;
+
+    WorkerPool(uint32_t count = 0); // 0 for one thread per core, minus the main thread
+    ~WorkerPool(); // Runs the queued jobs before joining
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    void submit(std::function<void()> job);
+    void wait_idle(); // Block until the queue is empty and no job is running
+
+    uint32_t size() const;
+
+    void run(); // Worker loop
+};
+
+#endif // ALCHEMIST_MEMORY_WORKER_POOL_HPP
@@ -2,12 +2,20 @@
 #ifndef ALCHEMIST_SCENES_DEFAULT_SCENE_HPP
 #define ALCHEMIST_SCENES_DEFAULT_SCENE_HPP
 
+#include <algorithm>
+
 #include "editor/scene.hpp"
 #include "editor/global.hpp"
 
 #include "server/render_pass.hpp"
+#include "server/transfer.hpp"
+#include "server/deletion.hpp"
+#include "server/vertex.hpp"
 
 #include "vulkan/render.hpp"
+#include "vulkan/recorder.hpp"
+#include "vulkan/render_queue.hpp"
+#include "vulkan/parallel_recorder.hpp"
 
 #include "math/quaternion.hpp"
 #include "math/vector/vec3.hpp"
@@ -35,6 +43,9 @@ struct DefaultScene : public Scene {
     virtual ~DefaultScene() override = default;
 
     RenderPassBegin render_pass_begin;
+    RenderQueue render_queue; // Draws of the frame, reused so recording does not allocate
+
+    static constexpr uint32_t PARALLEL_DRAW_THRESHOLD = 1024; // Draws in a pass before it is recorded on the worker threads
 
     RID gizmo;
     RID cube;
@@ -151,34 +162,31 @@ struct DefaultScene : public Scene {
             .build(); // Build the buffer
 
         MeshServer &mesh_server = MeshServer::instance();
+        uint16_t face_indices[36];
+        for (uint16_t face = 0; face < 6; ++face) {
+            const uint16_t quad[6] = {0, 1, 2, 2, 1, 3}; // The two triangles of the face strip
+            for (uint16_t corner = 0; corner < 6; ++corner) {
+                face_indices[face * 6 + corner] = face * 4 + quad[corner];
+            }
+        }
+
         gizmo = mesh_server.new_mesh()
-            .add_data(lines, 6) // Add vertex data
-            .add_data(color, 6) // Add color data
+            .set_quantized() // Half float positions and 8 bit colors, line.vert reads them as floats unchanged
+            .interleave<PositionColorVertex>(6, lines, color) // Positions and colors in one stream
+            .set_optimized(VK_PRIMITIVE_TOPOLOGY_LINE_LIST) // Indexed with 16 bit indices, like the cube
+            .set_shared() // Shares its arena with every other quantized position and color mesh
             .build(); // Build the mesh
         
         cube = mesh_server.new_mesh()
-            .add_data(faces, 24) // Add vertex data for cube faces
-            .add_data(normals, 24) // Add color data for cube faces
+            .interleave<PositionNormalVertex>(24, faces, normals) // Positions and normals in one stream
+            .add_indices(face_indices, 36)
+            .set_optimized() // One triangle list instead of a strip per face
+            .set_shared()
             .build(); // Build the cube mesh
 
         VkMemoryRequirements requirements;
-        mesh_server.get_requirements(gizmo, requirements);
         VkMemoryRequirements requirements2;
-        mesh_server.get_requirements(cube, requirements2);
-
-        requirements.memoryTypeBits &= requirements2.memoryTypeBits; // Ensure memory type bits are compatible
-        requirements.size += requirements2.size; // Combine sizes for both meshes
-
         GpuMemoryServer &gpu_memory_server = GpuMemoryServer::instance();
-        RID memory = gpu_memory_server.allocate_block<VkBuffer>(
-            requirements.size, 
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
-            find_memory_type(
-                Global::instance().rendering_device.physical_device,
-                requirements.memoryTypeBits, 
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-            )
-        );
 
         buffer_server.get_requirements(camera_ubo, requirements);
         buffer_server.get_requirements(gizmo_ubo, requirements2);
@@ -187,13 +195,14 @@ struct DefaultScene : public Scene {
         requirements.size += requirements2.size; // Combine sizes for both buffers
 
         ubo_memory = gpu_memory_server.allocate_block<VkBuffer>(
-            sizeof(LineData) * 6 + sizeof(CameraData), // Size for 6 gizmos
+            requirements.size + requirements2.alignment, // Both buffers, the second one aligned after the first
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, // Memory properties
             find_memory_type(
                 Global::instance().rendering_device.physical_device,
                 requirements.memoryTypeBits, 
                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-            )
+            ),
+            FreeList // Each buffer gives its range back when it is released
         );
 
         const Buffer &camera_ubo_buffer = buffer_server.get_buffer(camera_ubo);
@@ -223,29 +232,18 @@ struct DefaultScene : public Scene {
             .set_buffer_info(gizmo_ubo_buffer.buffer, 0, sizeof(LineData)); // Sejt buffer info for the uniform buffer
         write.update(); // Update the descriptor set with the new data
 
-        mesh_server.bind_mesh(gizmo, memory); // Bind the mesh to the GPU memory
-        mesh_server.bind_mesh(cube, memory); // Bind the cube mesh to the GPU memory
-        
-        Global &global = Global::instance();
-        
-        CommandBuffer cmd_buffer = allocate_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, global.command_pool);
-
-        cmd_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT); // Begin the command buffer
-
-        buffer_server.execute_commands(cmd_buffer.buffer); // Execute any pending buffer commands
-
-        cmd_buffer.end(); // End the command buffer
-
-        QueueServer::instance().get_queue(global.graphic_queue)
-            .submit()
-            .add_command_buffer(cmd_buffer)
-            .submit().wait(); // Submit the command buffer to the graphics queue
-        
-        buffer_server.clear_commands(); // Clear the command buffer commands
+        TransferServer::instance().flush(); // Upload on the transfer queue, the next frame waits on it
     }
 
     void exit() override {
-        // Clean up resources used by the default scene
+        // Frames in flight may still draw with them, destroyed once they retire
+        DeletionQueue &deletion_queue = DeletionQueue::instance();
+        deletion_queue.release(gizmo);
+        deletion_queue.release(cube);
+        deletion_queue.release(camera_ubo);
+        deletion_queue.release(gizmo_ubo);
+        deletion_queue.release(ubo_memory); // After the resources bound to it, the queue keeps the release order
+        ubo_data = nullptr;
     }
 
     void update(float delta_time) override {
@@ -268,16 +266,48 @@ struct DefaultScene : public Scene {
         // }
     }
 
-    void render(VkCommandBuffer command_buffer, uint32_t image_index) override {
+    void render(CommandRecorder &recorder, uint32_t image_index) override {
         Global &global = Global::instance();
 
-        uint32_t offset = 0;
+        const LineData *gizmo_data_ptr = reinterpret_cast<const LineData *>((uint8_t*)ubo_data + sizeof(CameraData));
+
+        render_queue.clear();
+
+        DrawPacket packet;
+        packet.layout = global.gizmo_pipeline_lyt;
+        packet.descriptor_set = global.desc;
+        packet.offset_count = 1;
+
+        const MeshServer &mesh_server = MeshServer::instance();
+
+        packet.pipeline = global.gizmo_pipeline;
+        packet.mesh = gizmo;
+        packet.indexed = true;
+        packet.count = mesh_server.get_mesh(gizmo).index_count;
+        for (uint32_t i = 0; i < 2; ++i) {
+            packet.offsets[0] = i * sizeof(LineData); // Per-gizmo data in the dynamic uniform buffer
+            packet.depth = (gizmo_data_ptr[i].root - global.camera.position).length();
+            render_queue.push(packet);
+        }
+
+        packet.pipeline = global.cube_pipeline;
+        packet.layout = global.cube_pipeline_lyt;
+        packet.mesh = cube;
+        packet.offsets[0] = sizeof(LineData); // The cube follows the second gizmo
+        packet.depth = (gizmo_data_ptr[1].root - global.camera.position).length();
+        packet.count = mesh_server.get_mesh(cube).index_count;
+        render_queue.push(packet);
+
+        render_queue.sort();
+
+        std::pair<uint32_t, uint32_t> range = render_queue.pass_range(0);
+        uint32_t first = range.first;
+        uint32_t last = range.second;
+        bool parallel = last - first >= PARALLEL_DRAW_THRESHOLD; // Below it the secondary buffers cost more than they save
 
         const RenderPass &pass = RenderPassServer::instance().get_render_pass(global.render_pass);
-        const Mesh &gizmo_mesh = MeshServer::instance().get_mesh(gizmo);
-        const Mesh &cube_mesh = MeshServer::instance().get_mesh(cube);
 
-        render_pass_begin = pass.begin(command_buffer);
+        render_pass_begin = pass.begin(recorder);
 
         render_pass_begin
             .set_framebuffer(global.framebuffer[image_index])
@@ -286,48 +316,30 @@ struct DefaultScene : public Scene {
             .add_clear_color(BLACK) // Clear color
             .add_clear_depth(1.0f); // Clear depth value
 
-        render_pass_begin.begin(); // Begin the render pass
-
-        bind_pipeline(command_buffer, global.gizmo_pipeline); // Bind the graphics pipeline
+        render_pass_begin.begin(parallel ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE); // Begin the render pass
 
+        VkExtent2D extent = global.rendering_device.swapchain_extent;
         VkRect2D scissor_rect = {
             {0, 0}, // Offset
-            global.rendering_device.swapchain_extent // Extent
+            extent // Extent
         };
 
-        viewport(command_buffer, global.rendering_device.swapchain_extent); // Set the viewport
-        scissor(command_buffer, scissor_rect); // Set the scissor rectangle
-
-        gizmo_mesh.bind(command_buffer); // Bind the gizmo mesh
-
-        bind_descriptor_sets(command_buffer, global.gizmo_pipeline_lyt, global.desc,
-            VK_PIPELINE_BIND_POINT_GRAPHICS, &offset); // Bind the descriptor sets
-
-        vkCmdDraw(command_buffer, 6, 1, 0, 0); // Draw the gizmo mesh
-
-        offset = sizeof(LineData); // Update offset for the next descriptor set
-
-        bind_descriptor_sets(command_buffer, global.gizmo_pipeline_lyt, global.desc,
-            VK_PIPELINE_BIND_POINT_GRAPHICS, &offset); // Bind the descriptor sets
-
-        vkCmdDraw(command_buffer, 6, 1, 0, 0); // Draw the gizmo mesh
-
-        bind_pipeline(command_buffer, global.cube_pipeline); // Bind the cube graphics pipeline
-
-        viewport(command_buffer, global.rendering_device.swapchain_extent); // Set the viewport
-        scissor(command_buffer, scissor_rect); // Set the scissor rectangle
-
-        cube_mesh.bind(command_buffer); // Bind the cube mesh
-
-        bind_descriptor_sets(command_buffer, global.gizmo_pipeline_lyt, global.desc,
-            VK_PIPELINE_BIND_POINT_GRAPHICS, &offset); // Bind the descriptor sets
-        
-        vkCmdDraw(command_buffer, 4, 1, 0, 0);
-        vkCmdDraw(command_buffer, 4, 1, 4, 0);
-        vkCmdDraw(command_buffer, 4, 1, 8, 0);
-        vkCmdDraw(command_buffer, 4, 1, 12, 0);
-        vkCmdDraw(command_buffer, 4, 1, 16, 0);
-        vkCmdDraw(command_buffer, 4, 1, 20, 0);
+        if (parallel) {
+            ParallelRecorder &parallel_recorder = *global.parallel_recorder;
+            uint32_t jobs = parallel_recorder.thread_count();
+            uint32_t chunk = (last - first + jobs - 1) / jobs;
+
+            parallel_recorder.record(recorder, global.render_pass, global.framebuffer[image_index], 0, jobs,
+                [&](CommandRecorder &secondary, uint32_t job) {
+                    secondary.viewport(extent); // Not inherited from the primary
+                    secondary.scissor(scissor_rect);
+                    render_queue.record(secondary, std::min(first + job * chunk, last), std::min(first + (job + 1) * chunk, last));
+                });
+        } else {
+            recorder.viewport(extent); // Set the viewport
+            recorder.scissor(scissor_rect); // Set the scissor rectangle
+            render_queue.record(recorder, first, last);
+        }
 
         render_pass_begin.end(); // End the render pass
     }
@@ -343,6 +355,9 @@ struct DefaultScene : public Scene {
             Global::instance().camera.position.x, 
             Global::instance().camera.position.y, 
             Global::instance().camera.position.z);
+        ImGui::Text("Commands: %u recorded, %u redundant dropped",
+            Global::instance().recorder.stats.emitted,
+            Global::instance().recorder.stats.skipped);
         ImGui::End();
         #endif // ALCHEMIST_DEBUG
     }
@@ -3,15 +3,19 @@
 #define ALCHEMIST_SERVER_BUFFER_HPP
 
 #include <vector>
+#include <initializer_list>
 
 #include <vulkan/vulkan.h>
 
 #include "server/rid.hpp"
+#include "server/staging.hpp"
+#include "memory/slot_map.hpp"
 
 struct BufferServer; // Forward declaration
 
 struct BufferBuilder {
     VkBufferCreateInfo create_info;
+    std::vector<uint32_t> queue_families; // Families sharing the buffer when it is concurrent
 
     BufferServer &server; // Reference to the BufferServer for building buffers
 
@@ -20,6 +24,7 @@ struct BufferBuilder {
     BufferBuilder &set_size(VkDeviceSize size);
     BufferBuilder &set_usage(VkBufferUsageFlags usage);
     BufferBuilder &set_sharing_mode(VkSharingMode sharing_mode);
+    BufferBuilder &set_queue_families(std::initializer_list<uint32_t> families); // Concurrent across the distinct families, exclusive if there is only one
 
     RID build() const; // Create the buffer and return its RID
 };
@@ -28,23 +33,21 @@ struct Buffer {
     VkBuffer buffer;
     RID rid = RID_INVALID; // Resource ID
     RID memory_rid = RID_INVALID; // Resource ID for the GPU memory block
-
-    ~Buffer();
+    RID bind_rid = RID_INVALID; // Resource ID of the bind inside the memory block
+    bool concurrent = false; // Shared by several queue families, uploads need no ownership transfer
 };
 
 struct CmdUploadBuffer {
     VkBuffer buffer;
-    VkBuffer staging;
-    RID memory_rid = RID_INVALID;
+    VkBuffer staging; // Staging ring buffer, owned by the BufferServer
+    bool concurrent = false; // Destination is concurrent, no ownership transfer
 
     VkBufferCopy copy_region;
 
     CmdUploadBuffer() = default;
-    CmdUploadBuffer(CmdUploadBuffer &&);
     CmdUploadBuffer(VkBuffer buffer);
-    ~CmdUploadBuffer();
 
-    CmdUploadBuffer &upload_data(VkDevice device, VkPhysicalDevice physical_device, VkDeviceSize size, const void *data);
+    CmdUploadBuffer &upload_data(VkDevice device, VkPhysicalDevice physical_device, VkDeviceSize size, const void *data, VkDeviceSize offset = 0); // offset is in the destination buffer
 };
 
 enum class BufferCommandType {
@@ -52,11 +55,13 @@ enum class BufferCommandType {
 };
 
 struct BufferServer {
-    std::vector<Buffer> buffers; // Vector to hold all buffers
+    SlotMap<Buffer, RIDServer::BUFFER> buffers; // Slot map holding all buffers
 
     std::vector<CmdUploadBuffer> upload_commands; // Vector to hold upload commands
     std::vector<BufferCommandType> command_types; // Vector to hold command types
 
+    StagingRing staging; // Persistently mapped staging memory shared by every upload
+
     VkDevice device; // Vulkan device
     VkPhysicalDevice physical_device; // Vulkan physical device
 
@@ -68,6 +73,8 @@ struct BufferServer {
 
     BufferBuilder new_buffer();
 
+    void free_buffer(RID rid); // Destroy the buffer and release its range in the memory block, the GPU must be done with it
+
     RID bind_buffer(RID buffer, RID memory);
     void bind_best(RID buffer, VkMemoryPropertyFlags flags);
 
@@ -77,6 +84,7 @@ struct BufferServer {
     CmdUploadBuffer &upload_buffer(RID rid);
 
     void execute_commands(VkCommandBuffer cmd_buffer);
+    void ownership_barriers(uint32_t src_family, uint32_t dst_family, std::vector<VkBufferMemoryBarrier> &release, std::vector<VkBufferMemoryBarrier> &acquire) const; // Queue family transfer of every buffer written by the pending commands
     void clear_commands(); // Clear the command buffers, make sure to wait for the commands to
 
     static BufferServer &instance();
@@ -2,22 +2,30 @@
 #ifndef ALCHEMIST_SERVER_COMMAND_POOL_HPP
 #define ALCHEMIST_SERVER_COMMAND_POOL_HPP
 
+#include <array>
 #include <vector>
 
 #include <vulkan/vulkan.h>
 
 #include "server/rid.hpp"
+#include "memory/slot_map.hpp"
 
 struct CommandPool {
     VkCommandPool command_pool; // Vulkan command pool object
     RID rid = RID_INVALID; // Resource ID for the command pool
 
     std::vector<VkCommandBuffer> command_buffers; // Vector to hold command buffers allocated from this pool
+    VkCommandPoolCreateFlags flags = 0; // Creation flags, buffers can only be released one by one with RESET_COMMAND_BUFFER
+
+    // Indexed by VkCommandBufferLevel
+    std::array<std::vector<VkCommandBuffer>, 2> free_buffers; // Reset buffers ready to be handed out again
+    std::array<std::vector<VkCommandBuffer>, 2> used_buffers; // Handed out since the last pool reset
 
     CommandPool() = default;
 };
 
 struct CommandPoolServer; // Forward declaration
+struct CommandBuffer;
 
 struct CommandPoolBuilder {
     VkCommandPoolCreateInfo create_info; // Vulkan command pool creation info
@@ -32,7 +40,7 @@ struct CommandPoolBuilder {
 };
 
 struct CommandPoolServer {
-    std::vector<CommandPool> command_pools; // Vector to hold all command pools
+    SlotMap<CommandPool, RIDServer::COMMAND_POOL> command_pools; // Slot map holding all command pools
 
     VkDevice device; // Vulkan device
 
@@ -46,6 +54,11 @@ struct CommandPoolServer {
 
     CommandPool &get_command_pool(RID rid);
 
+    // Recycled buffers come first, a pool in steady state allocates nothing
+    CommandBuffer acquire_command_buffer(RID pool, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    void release_command_buffer(RID pool, CommandBuffer buffer, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY); // The GPU must be done with it
+    void reset_command_pool(RID pool); // Reset every buffer at once and recycle them, the GPU must be done with all of them
+
     static CommandPoolServer &instance();
     static std::unique_ptr<CommandPoolServer> __instance; // Singleton instance of CommandPoolServer
 };
@@ -0,0 +1,49 @@
+
+#ifndef ALCHEMIST_SERVER_DELETION_HPP
+#define ALCHEMIST_SERVER_DELETION_HPP
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "server/rid.hpp"
+#include "vulkan/sync.hpp"
+
+struct PendingDeletion {
+    RID rid = RID_INVALID; // The server is picked from the RID type
+    uint64_t frame = 0; // Frame being recorded when the resource was released
+};
+
+struct PendingFutureDeletion {
+    RID rid = RID_INVALID;
+    GpuFuture future; // Destroyed once the submission completes
+};
+
+// Resources released while frames may still use them, destroyed once those frames have retired
+// Supports buffers, meshes, images, image views, framebuffers, memory blocks, pipelines, layouts and descriptor sets
+struct DeletionQueue {
+    std::deque<PendingDeletion> pending; // Oldest frame first
+    std::vector<PendingFutureDeletion> pending_futures; // Waiting on a timeline value, in no particular order
+
+    uint32_t frames_in_flight; // A frame is done once the fence of the frame frames_in_flight later has been waited on
+    uint64_t frame = 0; // Frames submitted so far, the index of the frame being recorded
+
+    DeletionQueue(uint32_t frames_in_flight);
+    ~DeletionQueue(); // Destroys everything left, the device must be idle
+
+    void release(RID rid); // Destroy after the frame being recorded retires
+    void release(RID rid, const GpuFuture &future); // Destroy after a submission completes, for resources used outside the frame
+
+    void collect(uint64_t frame_count); // Destroy what retired, once the fence of the frame frame_count is waited on
+    void flush(); // Destroy everything now, the device must be idle
+
+    size_t size() const; // Resources waiting to be destroyed
+
+    static void destroy(RID rid);
+
+    static DeletionQueue &instance();
+    static std::unique_ptr<DeletionQueue> __instance; // Singleton instance of DeletionQueue
+};
+
+#endif // ALCHEMIST_SERVER_DELETION_HPP
@@ -2,12 +2,15 @@
 #ifndef ALCHEMIST_SERVER_DESCRIPTOR_HPP
 #define ALCHEMIST_SERVER_DESCRIPTOR_HPP
 
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <cstdint>
 
 #include <vulkan/vulkan.h>
 
 #include "server/rid.hpp"
+#include "memory/slot_map.hpp"
 
 struct DescriptorPool {
     VkDescriptorPool pool; // Vulkan descriptor pool object
@@ -19,6 +22,7 @@ struct DescriptorPool {
 struct DescriptorLayout {
     VkDescriptorSetLayout layout; // Vulkan descriptor set layout object
     RID rid = RID_INVALID; // Resource ID for the descriptor layout
+    uint32_t references = 1; // Builds that resolved to this layout, each one frees it once
 
     DescriptorLayout() = default;
 };
@@ -111,7 +115,7 @@ struct DescriptorLayoutBuilder {
 };
 
 struct DescriptorPoolServer {
-    std::vector<DescriptorPool> descriptor_pools; // Vector to hold all descriptor pools
+    SlotMap<DescriptorPool, RIDServer::DESCRIPTOR_POOL> descriptor_pools; // Slot map holding all descriptor pools
 
     VkDevice device; // Vulkan device
 
@@ -123,14 +127,15 @@ struct DescriptorPoolServer {
 
     DescriptorPoolBuilder new_descriptor_pool(); // Create a new descriptor pool builder
 
-    const DescriptorPool &get_descriptor_pool(RID rid);
+    const DescriptorPool &get_descriptor_pool(RID rid) const;
 
     static DescriptorPoolServer &instance();
     static std::unique_ptr<DescriptorPoolServer> __instance; // Singleton instance of descriptorPoolServer
 };
 
 struct DescriptorLayoutServer {
-    std::vector<DescriptorLayout> descriptor_layouts; // Vector to hold all descriptor layouts
+    SlotMap<DescriptorLayout, RIDServer::DESCRIPTOR_LAYOUT> descriptor_layouts; // Slot map holding all descriptor layouts
+    std::unordered_map<std::string, RID> layout_keys; // Canonical state key -> layout, identical layouts are created once
 
     VkDevice device; // Vulkan device
 
@@ -142,14 +147,16 @@ struct DescriptorLayoutServer {
 
     DescriptorLayoutBuilder new_descriptor_layout(); // Create a new descriptor layout builder
 
-    const DescriptorLayout &get_descriptor_layout(RID rid);
+    void free_descriptor_layout(RID rid); // Destroyed once every build that resolved to it has freed it
+
+    const DescriptorLayout &get_descriptor_layout(RID rid) const;
 
     static DescriptorLayoutServer &instance();
     static std::unique_ptr<DescriptorLayoutServer> __instance; // Singleton instance of descriptorLayoutServer
 };
 
 struct DescriptorServer {
-    std::vector<Descriptor> descriptors; // Vector to hold all descriptors
+    SlotMap<Descriptor, RIDServer::DESCRIPTOR_SET> descriptors; // Slot map holding all descriptors
 
     VkDevice device; // Vulkan device
 
@@ -158,6 +165,7 @@ struct DescriptorServer {
 
     RID new_descriptor(RID pool, RID layout);
     void emplace_descriptors(std::vector<RID> &descriptors, RID pool, RID layout, uint32_t count);
+    void free_descriptor(RID rid); // Give the set back to its pool, the GPU must be done with it
 
     const Descriptor &get_descriptor(RID rid) const;
 
@@ -7,12 +7,11 @@
 #include <vulkan/vulkan.h>
 
 #include "server/rid.hpp"
+#include "memory/slot_map.hpp"
 
 struct Framebuffer {
     VkFramebuffer framebuffer; // Vulkan framebuffer object
     RID rid = RID_INVALID; // Resource ID for the framebuffer
-
-    Framebuffer() = default;
 };
 
 struct FramebufferServer; // Forward declaration
@@ -39,7 +38,7 @@ struct FramebufferBuilder {
 };
 
 struct FramebufferServer {
-    std::vector<Framebuffer> framebuffers; // Vector to hold all framebuffers
+    SlotMap<Framebuffer, RIDServer::FRAMEBUFFER> framebuffers; // Slot map holding all framebuffers
     VkDevice device; // Vulkan device
 
     FramebufferServer(VkDevice device);
@@ -50,6 +49,8 @@ struct FramebufferServer {
 
     FramebufferBuilder new_framebuffer(uint32_t width, uint32_t height, uint32_t layers = 1);
 
+    void free_framebuffer(RID rid); // The GPU must be done with the framebuffer
+
     const Framebuffer &get_framebuffer(RID rid) const;
 
     static FramebufferServer &instance();
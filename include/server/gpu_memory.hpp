@@ -7,10 +7,17 @@
 #endif // ALCHEMIST_DEBUG
 
 #include <memory>
+#include <vector>
+#include <map>
+#include <set>
+#include <bit>
+#include <algorithm>
+#include <iterator>
 
 #include <vulkan/vulkan.h>
 
 #include "memory/vector.hpp"
+#include "memory/slot_map.hpp"
 #include "server/rid.hpp"
 
 template <typename T>
@@ -38,12 +45,7 @@ struct Bind {
     VkDeviceSize offset; // Offset in the device memory
     VkDeviceSize size; // Size of the data in bytes
 
-    RID rid; // Resource ID for tracking
-
-    Bind() = default;
-    ~Bind() {
-        RIDServer::instance().free(RIDServer::BIND, rid); // Free the RID when the bind is destroyed
-    }
+    RID rid = RID_INVALID; // Resource ID for tracking
 };
 
 
@@ -51,15 +53,22 @@ struct Bind {
 enum GpuDeviceMemoryAllocationMethod {
     Linear,
     Geometric,
+    FreeList,
+    Buddy,
 };
 
 
 
-template <typename T, GpuDeviceMemoryAllocationMethod M = Linear>
+template <typename T>
 struct GpuDeviceMemory {
-    std::vector<Bind<T>> binds; // Vector of binds on this GPU Device Memory
+    SlotMap<Bind<T>, RIDServer::BIND> binds; // Binds on this GPU Device Memory
+
+    std::map<VkDeviceSize, VkDeviceSize> free_ranges; // Free ranges (offset -> size) sorted by offset, used by FreeList
+    std::vector<std::set<VkDeviceSize>> buddy_free; // Free block offsets per order, order k spans BUDDY_MIN_SIZE << k bytes, used by Buddy
+
+    static constexpr VkDeviceSize BUDDY_MIN_SIZE = 256; // Smallest buddy block
 
-    void (*__reallocate)(GpuDeviceMemory<T> &, VkDevice, VkDeviceSize) = nullptr; // Function pointer for reallocation logic
+    GpuDeviceMemoryAllocationMethod method = Linear; // How binds are placed in the block
 
     VkDeviceMemory device; // Device memory object
 
@@ -68,21 +77,32 @@ struct GpuDeviceMemory {
     VkMemoryPropertyFlags properties = 0; // Memory properties (e.g., VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
 
     VkDeviceSize capacity = 0; // Total capacity of the memory block in bytes
-    VkDeviceSize size = 0; // Current size of the memory block in bytes
+    VkDeviceSize size = 0; // Current size of the memory block in bytes, bytes in use for FreeList and Buddy
+    VkDeviceSize granularity = 1; // bufferImageGranularity, images are kept on their own pages
 
-    RID rid = 0; // Resource ID for tracking
-
-    ~GpuDeviceMemory() {
-        RIDServer::instance().free(RIDServer::MEMORY, rid); // Free the RID when the memory is destroyed
-    }
+    RID rid = RID_INVALID; // Resource ID for tracking
 
     void allocate(VkDevice dev, VkDeviceSize capacity) {
+        if (method == Buddy) {
+            capacity = std::bit_ceil(std::max(capacity, BUDDY_MIN_SIZE)); // Buddy blocks split a power of two
+        }
+
         VkMemoryAllocateInfo alloc_info{};
         alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
         alloc_info.allocationSize = capacity;
         alloc_info.memoryTypeIndex = type_idx;
 
         this->capacity = capacity;
+        this->size = 0;
+
+        free_ranges.clear();
+        free_ranges.emplace(0, capacity); // The whole block is free
+
+        buddy_free.clear();
+        if (method == Buddy) {
+            buddy_free.resize(buddy_order(capacity) + 1);
+            buddy_free.back().insert(0); // One free block of the top order
+        }
 
         if (vkAllocateMemory(dev, &alloc_info, nullptr, &device) != VK_SUCCESS) {
             #ifdef ALCHEMIST_DEBUG
@@ -92,12 +112,24 @@ struct GpuDeviceMemory {
         }
     }
 
-    void reallocate(VkDevice dev, VkDeviceSize new_capacity) {
-        __reallocate(*this, dev, new_capacity);
+    // Bound resources can't be moved to a new allocation, so only an empty block can grow
+    bool reallocate(VkDevice dev, VkDeviceSize new_capacity) {
+        if (!binds.empty()) {
+            #ifdef ALCHEMIST_DEBUG
+            std::cerr << "Cannot reallocate GPU memory with live binds!" << std::endl;
+            #endif
+            return false;
+        }
+
+        if (device != VK_NULL_HANDLE) {
+            vkFreeMemory(dev, device, nullptr);
+        }
+        allocate(dev, new_capacity);
+        return device != VK_NULL_HANDLE;
     }
 
     uint32_t is_valid(const VkMemoryRequirements &requirements) const {
-        if (requirements.memoryTypeBits & (1 << type_idx) == 0) {
+        if ((requirements.memoryTypeBits & (1u << type_idx)) == 0) {
             #ifdef ALCHEMIST_DEBUG
             std::cerr << "Memory type index does not match the requirements!" << std::endl;
             #endif
@@ -114,43 +146,233 @@ struct GpuDeviceMemory {
         return 1; // Return 1 if the memory is valid for allocation
     }
 
-    RID bind(VkDevice dev, const VkMemoryRequirements &requirements, T data) {
-        VkDeviceSize aligned_size = (requirements.size + requirements.alignment - 1) & ~(requirements.alignment - 1);
+    static constexpr VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Alignment and size of a bind once bufferImageGranularity is applied
+    VkMemoryRequirements placement(const VkMemoryRequirements &requirements) const {
+        VkMemoryRequirements placed = requirements;
+        if constexpr (std::is_same_v<T, VkImage>) {
+            placed.alignment = std::max(placed.alignment, granularity); // Start on a fresh page
+            placed.size = align_up(placed.size, granularity); // Don't share the last page either
+        }
+        placed.size = align_up(placed.size, placed.alignment);
+        if (method == Buddy) {
+            placed.size = BUDDY_MIN_SIZE << buddy_order(std::max(placed.size, placed.alignment)); // Buddy blocks are naturally aligned to their size
+        }
+        return placed;
+    }
+
+    // First fit over the free ranges, the alignment padding stays in the free list
+    VkDeviceSize take_range(VkDeviceSize bytes, VkDeviceSize alignment) {
+        for (auto it = free_ranges.begin(); it != free_ranges.end(); ++it) {
+            VkDeviceSize range_offset = it->first;
+            VkDeviceSize range_end = it->first + it->second;
+            VkDeviceSize start = align_up(range_offset, alignment);
+
+            if (start + bytes > range_end) {
+                continue; // Doesn't fit in this range
+            }
+
+            free_ranges.erase(it);
+            if (start > range_offset) {
+                free_ranges.emplace(range_offset, start - range_offset); // Keep the padding before the bind
+            }
+            if (start + bytes < range_end) {
+                free_ranges.emplace(start + bytes, range_end - start - bytes); // Keep the tail after the bind
+            }
+            return start;
+        }
+        return VK_WHOLE_SIZE; // No range is large enough
+    }
+
+    // Give a range back to the free list and merge it with its neighbours
+    void release_range(VkDeviceSize offset, VkDeviceSize bytes) {
+        auto next = free_ranges.lower_bound(offset);
+        if (next != free_ranges.end() && offset + bytes == next->first) {
+            bytes += next->second; // Merge with the following range
+            next = free_ranges.erase(next);
+        }
+        if (next != free_ranges.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset) {
+                prev->second += bytes; // Merge with the preceding range
+                return;
+            }
+        }
+        free_ranges.emplace(offset, bytes);
+    }
+
+    static uint32_t buddy_order(VkDeviceSize bytes) {
+        return std::countr_zero(std::bit_ceil(std::max(bytes, BUDDY_MIN_SIZE)) / BUDDY_MIN_SIZE);
+    }
 
-        if (requirements.memoryTypeBits & (1 << type_idx) == 0) {
+    // Pop the lowest free block of the smallest order that fits and split it down, O(log n)
+    VkDeviceSize take_buddy(VkDeviceSize bytes) {
+        uint32_t order = buddy_order(bytes);
+        uint32_t found = order;
+        while (found < buddy_free.size() && buddy_free[found].empty()) {
+            found++;
+        }
+        if (found >= buddy_free.size()) {
+            return VK_WHOLE_SIZE; // No block is large enough
+        }
+
+        VkDeviceSize offset = *buddy_free[found].begin();
+        buddy_free[found].erase(buddy_free[found].begin());
+        while (found > order) {
+            found--;
+            buddy_free[found].insert(offset + (BUDDY_MIN_SIZE << found)); // The upper half becomes a free buddy
+        }
+        return offset;
+    }
+
+    // Free a block and merge it with its buddy as long as the buddy is free, O(log n)
+    void release_buddy(VkDeviceSize offset, VkDeviceSize bytes) {
+        uint32_t order = buddy_order(bytes);
+        while (order + 1 < buddy_free.size()) {
+            auto buddy = buddy_free[order].find(offset ^ (BUDDY_MIN_SIZE << order));
+            if (buddy == buddy_free[order].end()) {
+                break; // Buddy is in use, stop merging
+            }
+            offset = std::min(offset, *buddy);
+            buddy_free[order].erase(buddy);
+            order++;
+        }
+        buddy_free[order].insert(offset);
+    }
+
+    // Largest bind that could be placed right now
+    VkDeviceSize largest_free() const {
+        if (method == FreeList) {
+            VkDeviceSize largest = 0;
+            for (const auto &[range_offset, range_size] : free_ranges) {
+                largest = std::max(largest, range_size);
+            }
+            return largest;
+        }
+        if (method == Buddy) {
+            for (size_t order = buddy_free.size(); order-- > 0;) {
+                if (!buddy_free[order].empty()) {
+                    return BUDDY_MIN_SIZE << order;
+                }
+            }
+            return 0;
+        }
+        return capacity - size; // Bump allocators only have the tail
+    }
+
+    // 0 when the free space is one contiguous range, close to 1 when it is scattered in small holes
+    float fragmentation() const {
+        VkDeviceSize free = capacity - size;
+        if (free == 0) {
+            return 0.0f;
+        }
+        return 1.0f - static_cast<float>(largest_free()) / static_cast<float>(free);
+    }
+
+    bool can_fit(const VkMemoryRequirements &requirements) const {
+        VkMemoryRequirements placed = placement(requirements);
+        if (method == Buddy) {
+            return placed.size <= largest_free();
+        }
+        if (method != FreeList) {
+            return binds.empty() || align_up(size, placed.alignment) + placed.size <= capacity; // Empty blocks can still grow
+        }
+        for (const auto &[range_offset, range_size] : free_ranges) {
+            if (align_up(range_offset, placed.alignment) + placed.size <= range_offset + range_size) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    RID bind(VkDevice dev, const VkMemoryRequirements &requirements, T data) {
+        if ((requirements.memoryTypeBits & (1u << type_idx)) == 0) {
             #ifdef ALCHEMIST_DEBUG
             std::cerr << "Memory type index does not match the requirements!" << std::endl;
             #endif
             return RID_INVALID; // Return 0 if the memory type index does not match
         }
 
-        if (size + aligned_size > capacity) {
-            if constexpr (M == Linear) {
-                uint32_t i = 2;
-                while (size + aligned_size > (capacity * i)) {
-                    i++;
+        VkMemoryRequirements placed = placement(requirements);
+        VkDeviceSize offset;
+
+        if (method == FreeList) {
+            offset = take_range(placed.size, placed.alignment);
+            if (offset == VK_WHOLE_SIZE) {
+                #ifdef ALCHEMIST_DEBUG
+                std::cerr << "No free range large enough for " << placed.size << " bytes!" << std::endl;
+                #endif
+                return RID_INVALID; // The block is full or too fragmented
+            }
+        } else if (method == Buddy) {
+            offset = take_buddy(placed.size);
+            if (offset == VK_WHOLE_SIZE) {
+                #ifdef ALCHEMIST_DEBUG
+                std::cerr << "No buddy block large enough for " << placed.size << " bytes!" << std::endl;
+                #endif
+                return RID_INVALID; // The block is full or too fragmented
+            }
+        } else {
+            offset = align_up(size, placed.alignment);
+            if (offset + placed.size > capacity) {
+                VkDeviceSize new_capacity = std::max<VkDeviceSize>(capacity, 1);
+                if (method == Linear) {
+                    uint32_t i = 2;
+                    while (offset + placed.size > (new_capacity * i)) {
+                        i++;
+                    }
+                    new_capacity *= i;
+                } else if (method == Geometric) {
+                    while (offset + placed.size > new_capacity) {
+                        new_capacity <<= 1; // Double the capacity
+                    }
                 }
-                capacity *= i;
-            } else if constexpr (M == Geometric) {
-                while (size + aligned_size > capacity) {
-                    capacity <<= 1; // Double the capacity
+                if (!reallocate(dev, new_capacity)) {
+                    return RID_INVALID; // Out of space and can't grow
                 }
             }
-            reallocate(dev, capacity);
         }
 
-        Bind<T> bind_info;
-        bind_info.data = data;
-        bind_info.offset = size;
-        bind_info.size = aligned_size;
-        bind_info.rid = RIDServer::instance().new_id(RIDServer::BIND); // Generate a new RID for the bind
+        RID bind_rid = binds.emplace(data, offset, placed.size); // Add the bind to the slot map
+        BindInterface<T>::bind(dev, data, this->device, offset);
+
+        if (method == FreeList || method == Buddy) {
+            size += placed.size; // Track the bytes in use
+        } else {
+            size = offset + placed.size; // Move the bump pointer
+        }
 
-        binds.emplace_back(std::move(bind_info)); // Add the bind to the vector
-        BindInterface<T>::bind(dev, data, this->device, size);
+        return bind_rid; // Return the RID of the bind
+    }
+
+    // Release a bind, its range goes back to the free list (FreeList) or rewinds the bump pointer if it was the last one
+    bool unbind(RID bind_rid) {
+        const Bind<T> *bind = binds.get(bind_rid);
+        if (bind == nullptr) {
+            #ifdef ALCHEMIST_DEBUG
+            std::cerr << "Bind with RID " << bind_rid << " not found for release!" << std::endl;
+            #endif
+            return false;
+        }
 
-        size += aligned_size; // Update the current size
+        if (method == FreeList) {
+            release_range(bind->offset, bind->size);
+            size -= bind->size;
+        } else if (method == Buddy) {
+            release_buddy(bind->offset, bind->size);
+            size -= bind->size;
+        } else if (bind->offset + bind->size == size) {
+            size = bind->offset; // Only the top of a bump allocator can be reclaimed
+        }
 
-        return bind_info.rid; // Return the RID of the bind
+        binds.erase(bind_rid);
+        if (binds.empty() && (method == Linear || method == Geometric)) {
+            size = 0; // Everything is free again
+        }
+        return true;
     }
 
     // will not succeed if the memory can't be mapped, there may be dragons
@@ -188,21 +410,19 @@ struct GpuDeviceMemory {
             return;
         }
 
-        for (const auto &bind : binds) {
-            if (bind.rid == rid) {
-                if (vkMapMemory(dev, this->device, bind.offset, bind.size, 0, data) != VK_SUCCESS) {
-                    #ifdef ALCHEMIST_DEBUG
-                    std::cerr << "Failed to map GPU memory for bind with RID: " << rid << std::endl;
-                    #endif
-                    *data = nullptr; // Reset data pointer on failure
-                } else {
-                    #ifdef ALCHEMIST_DEBUG
-                    std::cerr << "Mapped GPU memory for bind with RID: " << rid << std::endl;
-                    std::cerr << *data << " at offset: " << bind.offset << " with size: " << bind.size << std::endl;
-                    #endif
-                }
-                return; // Return if bind is found and mapped successfully
+        if (const Bind<T> *bind = binds.get(rid)) {
+            if (vkMapMemory(dev, this->device, bind->offset, bind->size, 0, data) != VK_SUCCESS) {
+                #ifdef ALCHEMIST_DEBUG
+                std::cerr << "Failed to map GPU memory for bind with RID: " << rid << std::endl;
+                #endif
+                *data = nullptr; // Reset data pointer on failure
+            } else {
+                #ifdef ALCHEMIST_DEBUG
+                std::cerr << "Mapped GPU memory for bind with RID: " << rid << std::endl;
+                std::cerr << *data << " at offset: " << bind->offset << " with size: " << bind->size << std::endl;
+                #endif
             }
+            return; // Return if bind is found and mapped successfully
         }
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Bind with RID " << rid << " not found for mapping!" << std::endl;
@@ -224,29 +444,24 @@ struct GpuDeviceMemory {
     }
 
     const Bind<T> &get_bind(RID rid) const {
-        for (const auto &bind : binds) {
-            if (bind.rid == rid) {
-                return bind; // Return the bind if found
-            }
+        if (const Bind<T> *bind = binds.get(rid)) {
+            return *bind; // Return the bind if found
         }
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Bind with RID " << rid << " not found!" << std::endl;
         #endif
-        return *((const Bind<T> *)nullptr); // Return a null bind if not found
+        return binds.at(rid); // Invalid bind as a fallback
     }
 };
 
 struct GpuMemoryServer {
-    std::vector<GpuDeviceMemory<VkBuffer>> buffers_memory; // Vector of GPU memory blocks for buffers
-    std::vector<GpuDeviceMemory<VkImage>> images_memory; // Vector of GPU memory blocks for images
+    SlotMap<GpuDeviceMemory<VkBuffer>, RIDServer::MEMORY> buffers_memory; // GPU memory blocks for buffers
+    SlotMap<GpuDeviceMemory<VkImage>, RIDServer::IMAGE_MEMORY> images_memory; // GPU memory blocks for images
 
     VkDevice device;
     VkPhysicalDevice physical_device;
 
-    GpuMemoryServer(VkDevice device, VkPhysicalDevice physical_device) : device(device), physical_device(physical_device) {
-        buffers_memory = std::vector<GpuDeviceMemory<VkBuffer>>();
-        images_memory = std::vector<GpuDeviceMemory<VkImage>>();
-    }
+    GpuMemoryServer(VkDevice device, VkPhysicalDevice physical_device) : device(device), physical_device(physical_device) {}
 
     ~GpuMemoryServer() {
         for (auto &block : buffers_memory) {
@@ -258,43 +473,71 @@ struct GpuMemoryServer {
     }
 
     template <typename T>
-    RID allocate_block(VkDeviceSize size, VkMemoryPropertyFlags flags, uint32_t type_index) {
-        GpuDeviceMemory<T> block;
+    auto &memory_blocks() {
+        if constexpr (std::is_same_v<T, VkBuffer>) {
+            return buffers_memory;
+        } else {
+            return images_memory;
+        }
+    }
+
+    template <typename T>
+    const auto &memory_blocks() const {
+        if constexpr (std::is_same_v<T, VkBuffer>) {
+            return buffers_memory;
+        } else {
+            return images_memory;
+        }
+    }
+
+    // Calls fn with the block behind rid, whatever its resource type, returns false if the RID is stale
+    template <typename F>
+    bool visit_block(RID rid, F &&fn) const {
+        if (const auto *block = buffers_memory.get(rid)) {
+            fn(*block);
+            return true;
+        }
+        if (const auto *block = images_memory.get(rid)) {
+            fn(*block);
+            return true;
+        }
+        return false;
+    }
+
+    template <typename T>
+    RID allocate_block(VkDeviceSize size, VkMemoryPropertyFlags flags, uint32_t type_index, GpuDeviceMemoryAllocationMethod method = Linear) {
+        RID rid = memory_blocks<T>().emplace(); // Construct the block in place, the slot map keeps it from moving
+        GpuDeviceMemory<T> &block = *memory_blocks<T>().get(rid);
         block.type_idx = type_index;
         block.properties = flags;
-        block.allocate(device, size);
-        block.rid = RIDServer::instance().new_id(RIDServer::MEMORY); // Generate a new RID for the memory block
-        
-        if constexpr (std::is_same_v<T, VkBuffer>) {
-            buffers_memory.emplace_back(std::move(block)); // Move the block into the vector
-        } else if constexpr (std::is_same_v<T, VkImage>) {
-            images_memory.emplace_back(std::move(block));
+        block.method = method;
+        if constexpr (std::is_same_v<T, VkImage>) {
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(physical_device, &properties);
+            block.granularity = std::max<VkDeviceSize>(properties.limits.bufferImageGranularity, 1); // Keep images off buffer pages
         }
+        block.allocate(device, size);
 
         #ifdef ALCHEMIST_DEBUG
-        std::cout << "Allocated GPU memory block with RID: " << block.rid << " of size: " << size << " bytes." << std::endl;
+        std::cout << "Allocated GPU memory block with RID: " << rid << " of size: " << size << " bytes." << std::endl;
         #endif
         
-        return block.rid; // Return the RID of the new block
+        return rid; // Return the RID of the new block
     }
 
     void free_block(RID rid) {
         #ifdef ALCHEMIST_DEBUG
         std::cout << "Freeing GPU memory block with RID: " << rid << std::endl;
         #endif
-        for (auto it = buffers_memory.begin(); it != buffers_memory.end(); ++it) {
-            if (it->rid == rid) {
-                vkFreeMemory(device, it->device, nullptr); // Free the buffer memory
-                buffers_memory.erase(it); // Remove the block from the vector
-                return;
-            }
+        if (auto *block = buffers_memory.get(rid)) {
+            vkFreeMemory(device, block->device, nullptr); // Free the buffer memory
+            buffers_memory.erase(rid); // Remove the block from the slot map
+            return;
         }
-        for (auto it = images_memory.begin(); it != images_memory.end(); ++it) {
-            if (it->rid == rid) {
-                vkFreeMemory(device, it->device, nullptr); // Free the image memory
-                images_memory.erase(it); // Remove the block from the vector
-                return;
-            }
+        if (auto *block = images_memory.get(rid)) {
+            vkFreeMemory(device, block->device, nullptr); // Free the image memory
+            images_memory.erase(rid); // Remove the block from the slot map
+            return;
         }
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Failed to free memory block with RID: " << rid << std::endl;
@@ -303,48 +546,28 @@ struct GpuMemoryServer {
 
     template <typename T>
     const GpuDeviceMemory<T> &get_memory_block(RID rid) const {
-        if constexpr (std::is_same_v<T, VkBuffer>) {
-            for (const auto &block : buffers_memory) {
-                if (block.rid == rid) {
-                    return block; // Return the block if found
-                }
-            }
-        } else if constexpr (std::is_same_v<T, VkImage>) {
-           for (const auto &block : images_memory) {
-                if (block.rid == rid) {
-                    return block; // Return the block if found
-                }
-            }
-        }
-        return *((const GpuDeviceMemory<T> *)nullptr); // Return the first block if not found (or handle error appropriately)
+        return memory_blocks<T>().at(rid); // Invalid block if not found
+    }
+
+    float fragmentation(RID rid) const {
+        float value = 0.0f; // 0 if not found
+        visit_block(rid, [&](const auto &block) {
+            value = block.fragmentation();
+        });
+        return value;
     }
 
     uint32_t is_valid(RID rid, const VkMemoryRequirements &requirements) const {
-        for (const auto &block : buffers_memory) {
-            if (block.rid == rid) {
-                return block.is_valid(requirements); // Check if the buffer memory is valid
-            }
-        }
-        for (const auto &block : images_memory) {
-            if (block.rid == rid) {
-                return block.is_valid(requirements); // Check if the image memory is valid
-            }
-        }
-        return 0; // Return 0 if not found
+        uint32_t valid = 0; // 0 if not found
+        visit_block(rid, [&](const auto &block) {
+            valid = block.is_valid(requirements); // Check if the memory block is valid
+        });
+        return valid;
     }
 
     void map_bind(RID block, RID bind, void **data) const {
-        for (const auto &b : buffers_memory) {
-            if (b.rid == block) {
-                b.map_bind(device, bind, data); // Map the buffer memory block
-                return;
-            }
-        }
-        for (const auto &i : images_memory) {
-            if (i.rid == block) {
-                i.map_bind(device, bind, data); // Map the image memory block
-                return;
-            }
+        if (visit_block(block, [&](const auto &b) { b.map_bind(device, bind, data); })) {
+            return;
         }
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Failed to map bind with RID: " << block << std::endl;
@@ -353,17 +576,8 @@ struct GpuMemoryServer {
     }
 
     void map(RID rid, void **data) const {
-        for (const auto &block : buffers_memory) {
-            if (block.rid == rid) {
-                block.map(device, data); // Map the buffer memory block
-                return;
-            }
-        }
-        for (const auto &block : images_memory) {
-            if (block.rid == rid) {
-                block.map(device, data); // Map the image memory block
-                return;
-            }
+        if (visit_block(rid, [&](const auto &block) { block.map(device, data); })) {
+            return;
         }
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Failed to map memory block with RID: " << rid << std::endl;
@@ -372,17 +586,8 @@ struct GpuMemoryServer {
     }
 
     void unmap(RID rid) const {
-        for (const auto &block : buffers_memory) {
-            if (block.rid == rid) {
-                block.unmap(device); // Unmap the buffer memory block
-                return;
-            }
-        }
-        for (const auto &block : images_memory) {
-            if (block.rid == rid) {
-                block.unmap(device); // Unmap the image memory block
-                return;
-            }
+        if (visit_block(rid, [&](const auto &block) { block.unmap(device); })) {
+            return;
         }
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Failed to unmap memory block with RID: " << rid << std::endl;
@@ -391,19 +596,11 @@ struct GpuMemoryServer {
 
     template <typename T>
     RID find_best(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags flags) {
-        if constexpr (std::is_same_v<T, VkBuffer>) {
-            for (const auto &block : buffers_memory) {
-                if (block.is_valid(requirements) && 
-                    (block.properties & flags) == flags) {
-                    return block.rid; // Return the first valid memory block
-                }
-            }
-        } else if constexpr (std::is_same_v<T, VkImage>) {
-            for (const auto &block : images_memory) {
-                if (block.is_valid(requirements) && 
-                    (block.properties & flags) == flags) {
-                    return block.rid; // Return the first valid memory block
-                }
+        for (const auto &block : memory_blocks<T>()) {
+            if (block.is_valid(requirements) && 
+                (block.properties & flags) == flags &&
+                block.can_fit(requirements)) {
+                return block.rid; // Return the first valid memory block
             }
         }
 
@@ -412,22 +609,26 @@ struct GpuMemoryServer {
 
     template <typename T>
     RID bind(RID rid, const VkMemoryRequirements &requirements, T data) {
-        if constexpr (std::is_same_v<T, VkBuffer>) {
-            for (auto &block : buffers_memory) {
-                if (block.rid == rid) {
-                    return block.bind(device, requirements, data); // Bind the buffer memory and return the RID
-                }
-            }
-        } else if constexpr (std::is_same_v<T, VkImage>) {
-            for (auto &block : images_memory) {
-                if (block.rid == rid) {
-                    return block.bind(device, requirements, data); // Bind the image memory and return the RID
-                }
-            }
+        if (auto *block = memory_blocks<T>().get(rid)) {
+            return block->bind(device, requirements, data); // Bind the memory and return the RID
         }
         return RID_INVALID; // Return 0 if not found
     }
 
+    // Release a bind from its block so the range can be reused, the resource must be destroyed first
+    bool unbind(RID rid, RID bind) {
+        if (auto *block = buffers_memory.get(rid)) {
+            return block->unbind(bind);
+        }
+        if (auto *block = images_memory.get(rid)) {
+            return block->unbind(bind);
+        }
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to unbind from memory block with RID: " << rid << std::endl;
+        #endif
+        return false;
+    }
+
     static GpuMemoryServer &instance();
 
     static std::unique_ptr<GpuMemoryServer> __instance; // Singleton instance of GpuMemoryServer
@@ -9,6 +9,8 @@
 #include "graphics/rendering_device.hpp"
 
 #include "server/rid.hpp"
+#include "server/staging.hpp"
+#include "memory/slot_map.hpp"
 
 struct ImageServer; // Forward declaration
 struct ImageViewServer; // Forward declaration
@@ -85,8 +87,7 @@ struct Image {
     VkImage image;
     RID rid = RID_INVALID; // Resource ID
     RID memory_rid = RID_INVALID; // Resource ID for the GPU memory block
-
-    ~Image();
+    RID bind_rid = RID_INVALID; // Resource ID of the bind inside the memory block
 };
 
 struct ImageView {
@@ -122,8 +123,7 @@ struct CmdTransitionImageLayout {
 
 struct CmdUploadImage {
     VkImage image;
-    VkBuffer staging;
-    RID memory_rid = RID_INVALID;
+    VkBuffer staging; // Staging ring buffer, owned by the ImageServer
 
     VkImageLayout layout;
 
@@ -131,7 +131,6 @@ struct CmdUploadImage {
 
     CmdUploadImage() = default;
     CmdUploadImage(VkImage image);
-    ~CmdUploadImage();
 
     CmdUploadImage &upload_data(VkDevice device, VkPhysicalDevice physical_device, VkDeviceSize size, const void *data);
     CmdUploadImage &set_layout(VkImageLayout image_layout);
@@ -144,13 +143,15 @@ enum class ImageCommandType {
 };
 
 struct ImageServer {
-    std::vector<Image> images; // Vector to hold device memory objects
+    SlotMap<Image, RIDServer::IMAGE> images; // Slot map holding all images
 
     std::vector<CmdTransitionImageLayout> transition_commands; // Vector to hold transition commands
     std::vector<CmdUploadImage> upload_commands; // Vector to hold upload commands
 
     std::vector<ImageCommandType> command_types; // Vector to hold command types
 
+    StagingRing staging; // Persistently mapped staging memory shared by every upload
+
     VkDevice device; // Vulkan device
     VkPhysicalDevice physical_device; // Vulkan physical device
 
@@ -162,6 +163,8 @@ struct ImageServer {
     
     ImageBuilder new_image();
 
+    void free_image(RID rid); // Destroy the image and release its range in the memory block, the GPU must be done with it
+
     void bind_image(RID image, RID memory);
     void bind_best(RID image, VkMemoryPropertyFlags flags);
 
@@ -172,6 +175,7 @@ struct ImageServer {
     CmdUploadImage &upload_image(RID rid);
 
     void execute_commands(VkCommandBuffer cmd_buffer);
+    void ownership_barriers(uint32_t src_family, uint32_t dst_family, std::vector<VkImageMemoryBarrier> &release, std::vector<VkImageMemoryBarrier> &acquire) const; // Queue family transfer of every image touched by the pending commands, in its final layout
     void clear_commands(); // Make sure to wait for the commands to finish before clearing, there may be dragons
 
     static ImageServer &instance();
@@ -180,7 +184,7 @@ struct ImageServer {
 };
 
 struct ImageViewServer {
-    std::vector<ImageView> image_views; // Vector to hold image views
+    SlotMap<ImageView, RIDServer::IMAGE_VIEW> image_views; // Slot map holding all image views
 
     VkDevice device; // Vulkan device
 
@@ -192,6 +196,8 @@ struct ImageViewServer {
 
     ImageViewBuilder new_image_view();
 
+    void free_image_view(RID rid); // The GPU must be done with the view
+
     const ImageView &get_image_view(RID rid) const;
 
     static ImageViewServer &instance();
@@ -199,7 +205,7 @@ struct ImageViewServer {
 };
 
 struct SamplerServer {
-    std::vector<Sampler> samplers; // Vector to hold samplers
+    SlotMap<Sampler, RIDServer::SAMPLER> samplers; // Slot map holding all samplers
 
     VkDevice device; // Vulkan device
 
@@ -2,6 +2,7 @@
 #ifndef ALCHEMIST_SERVER_MESH_HPP
 #define ALCHEMIST_SERVER_MESH_HPP
 
+#include <array>
 #include <vector>
 #include <cstdint>
 #include <cstring>
@@ -10,15 +11,34 @@
 #include <vulkan/vulkan.h>
 
 #include "server/rid.hpp"
+#include "server/mesh_arena.hpp"
+#include "server/vertex.hpp"
+#include "memory/slot_map.hpp"
 
 struct Mesh {
+    static constexpr uint32_t MAX_BINDINGS = MeshArenaChunk::MAX_STREAMS; // Vertex streams a mesh can hold
+    static constexpr uint32_t STANDALONE = UINT32_MAX; // Arena of a mesh owning its buffer
+
     RID rid = RID_INVALID; // Resource ID for the mesh
     RID buffer = RID_INVALID; // RID for the buffer
 
-    std::vector<uint64_t> offsets; // Offsets for the mesh data in the buffer, last is indices offset if present
+    // Filled once when the mesh is built, binding needs no lookup nor allocation
+    VkBuffer handle = VK_NULL_HANDLE; // Vulkan buffer behind the RID
+    uint32_t binding_count = 0; // Vertex streams, one binding each
+    std::array<VkBuffer, MAX_BINDINGS> vertex_buffers = {}; // handle repeated for every binding
+    std::array<VkDeviceSize, MAX_BINDINGS> vertex_offsets = {}; // Offset of each stream in the buffer
+
+    VkDeviceSize index_offset = 0; // Offset of the indices in the buffer
     VkIndexType index_type = VK_INDEX_TYPE_MAX_ENUM; // Type of indices used in the mesh
 
-    ~Mesh();
+    // Place of the mesh in its buffer, all zero for a standalone mesh, draws add them to their own ranges
+    uint32_t arena = STANDALONE; // Index in MeshServer::arenas, the buffer is shared with the other meshes of the arena
+    uint32_t chunk = 0; // Chunk of the arena holding the mesh
+    uint32_t first_vertex = 0;
+    uint32_t vertex_count = 0;
+    uint32_t first_index = 0;
+    uint32_t index_count = 0;
+    int32_t vertex_offset = 0; // Added to the indices, the indices stay relative to the mesh
 
     void bind(VkCommandBuffer cmd_buffer) const;
 };
@@ -34,6 +54,17 @@ struct MeshBuilder {
     std::vector<uint64_t> offsets; // Offsets for the mesh data in the buffer, last is indices offset if present
     VkIndexType index_type = VK_INDEX_TYPE_MAX_ENUM; // Type of indices used in the mesh
 
+    std::vector<uint32_t> strides; // Bytes per vertex of each stream
+    uint32_t vertex_count = 0; // Vertices of the first stream, every stream must match it
+    uint32_t index_count = 0;
+
+    bool shared = false; // Sub-allocate from the arena of the layout instead of creating a buffer
+    bool quantized = false; // Vertex structs with a quantized form are stored packed
+    bool optimized = false; // Deduplicate and reorder the vertices and indices at build
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST; // Drawn with, only triangle lists can have their primitives reordered
+
+    VkFormat position_format = VK_FORMAT_UNDEFINED; // First attribute of the first stream, the overdraw pass needs 32 bit float positions
+
     MeshServer &server; // Reference to the MeshServer for building meshes
 
     MeshBuilder(MeshServer &server);
@@ -41,41 +72,67 @@ struct MeshBuilder {
 
     template <typename T>
     MeshBuilder &add_data(const T *data, uint64_t size) {
-        if (index_type != VK_INDEX_TYPE_MAX_ENUM) {
-            #ifdef ALCHEMIST_DEBUG
-            std::cerr << "Index type already set, cannot add mesh data!" << std::endl;
-            #endif
-            return *this; // If index type is already set, return without adding data
+        if (strides.empty()) {
+            position_format = first_attribute_format<T>();
         }
+        return add_stream(data, sizeof(T), size);
+    }
 
-        this->data = realloc(this->data, this->size + size * sizeof(T)); // Allocate memory for the mesh data
-        std::memcpy((uint8_t*)this->data + this->size, data, size * sizeof(T)); // Copy the data into the allocated memory
-        offsets.push_back(this->size); // Add the current size as an offset
-        this->size += size * sizeof(T); // Set the size of the mesh data
-        return *this; // Return the builder for chaining
+    MeshBuilder &add_stream(const void *data, uint32_t stride, uint64_t count); // One non interleaved stream of count vertices, dropped if count differs from the first stream
+
+    // One interleaved stream, matching VertexInput::add_vertex<V>, or add_vertex<QuantizedVertex<V>> once set_quantized
+    template <typename V>
+    requires InterleavedVertex<V>
+    MeshBuilder &add_vertices(const V *vertices, uint64_t count) {
+        if constexpr (QuantizableVertex<V>) {
+            if (quantized) {
+                std::vector<QuantizedVertex<V>> packed(count);
+                for (uint64_t i = 0; i < count; ++i) {
+                    packed[i] = quantize(vertices[i]);
+                }
+                return add_data(packed.data(), count);
+            }
+        }
+        return add_data(vertices, count);
+    }
+
+    // Interleave one array per attribute of V into a single stream
+    template <typename V, typename... Streams>
+    requires InterleavedVertex<V>
+    MeshBuilder &interleave(uint64_t count, const Streams *...streams) {
+        std::vector<V> vertices(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            V::Attributes::gather(vertices[i], i, streams...);
+        }
+        return add_vertices(vertices.data(), count);
     }
 
     template <typename T>
     requires std::is_integral_v<T>
     MeshBuilder &add_indices(const T *data, uint64_t size) {
-        if (index_type == VK_INDEX_TYPE_MAX_ENUM) {
-            index_type = std::is_same_v<T, uint16_t> ? VK_INDEX_TYPE_UINT16 :
-                          std::is_same_v<T, uint32_t> ? VK_INDEX_TYPE_UINT32 :
-                          std::is_same_v<T, uint8_t> ? VK_INDEX_TYPE_UINT8 :
-                          VK_INDEX_TYPE_MAX_ENUM; // Set the index type based on the type of T
-        }
-        this->data = realloc(this->data, this->size + size * sizeof(T)); // Allocate memory for the mesh data
-        std::memcpy((uint8_t*)this->data + this->size, data, size * sizeof(T)); // Copy the indices into the allocated memory
-        offsets.push_back(this->size); // Add the current size as an offset
-        this->size += size * sizeof(T); // Set the size of the mesh data
-        return *this; // Return the builder for chaining
+        VkIndexType type = std::is_same_v<T, uint16_t> ? VK_INDEX_TYPE_UINT16 :
+                           std::is_same_v<T, uint32_t> ? VK_INDEX_TYPE_UINT32 :
+                           std::is_same_v<T, uint8_t> ? VK_INDEX_TYPE_UINT8 :
+                           VK_INDEX_TYPE_MAX_ENUM; // Set the index type based on the type of T
+        return add_index_data(data, type, size);
     }
 
+    MeshBuilder &add_index_data(const void *data, VkIndexType type, uint64_t count);
+
+    MeshBuilder &set_shared(bool shared = true); // Place the mesh in the arena of its layout, bound memory included
+    MeshBuilder &set_quantized(bool quantized = true); // Compress the vertices added after it, see QuantizedVertex
+    // Merge duplicate vertices, order the triangles for the vertex cache and overdraw, then the vertices for fetch
+    // Non indexed meshes get indices, 16 bit ones whenever the vertex count allows it
+    MeshBuilder &set_optimized(VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+
     RID build() const; // Create the mesh and return its RID
+    RID build_shared() const; // build() of a shared mesh
+    bool optimize_into(MeshBuilder &out) const; // Fill out with the optimized mesh, false if the indices can't be optimized
 };
 
 struct MeshServer {
-    std::vector<Mesh> meshes; // Vector to hold all meshes
+    SlotMap<Mesh, RIDServer::MESH> meshes; // Slot map holding all meshes
+    std::vector<MeshArena> arenas; // Shared buffers of the meshes built with set_shared, one per vertex layout
     
     VkDevice device;
     VkPhysicalDevice physical_device;
@@ -83,13 +140,16 @@ struct MeshServer {
     MeshServer(VkDevice device, VkPhysicalDevice physical_device);
 
     MeshBuilder new_mesh();
+    void free_mesh(RID mesh); // Free the mesh and its buffer, or its arena ranges, the GPU must be done with them
 
-    void bind_mesh(RID mesh, RID memory);
+    void bind_mesh(RID mesh, RID memory); // Standalone meshes only, arena memory is bound with the arena
 
     void get_requirements(RID mesh, VkMemoryRequirements &requirements) const;
 
     const Mesh &get_mesh(RID mesh) const;
 
+    uint32_t find_arena(const std::vector<uint32_t> &strides, VkIndexType index_type); // Created on first use
+
     static MeshServer &instance();
 
     static std::unique_ptr<MeshServer> __instance; // Singleton instance of MeshServer
@@ -0,0 +1,66 @@
+
+#ifndef ALCHEMIST_SERVER_MESH_ARENA_HPP
+#define ALCHEMIST_SERVER_MESH_ARENA_HPP
+
+#include <array>
+#include <map>
+#include <vector>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "server/rid.hpp"
+
+// First fit free list over element ranges, merged with their neighbours on release
+struct RangeList {
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    std::map<uint32_t, uint32_t> free_ranges; // Free ranges (first -> count) sorted by first element
+
+    void reset(uint32_t capacity); // The whole range is free
+
+    uint32_t take(uint32_t count); // First element of the range, NONE if nothing fits
+    void release(uint32_t first, uint32_t count);
+};
+
+// One buffer holding every stream of the layout side by side, then the indices
+struct MeshArenaChunk {
+    static constexpr uint32_t MAX_STREAMS = 16;
+
+    RID buffer = RID_INVALID;
+    RID memory = RID_INVALID; // Dedicated memory block of the buffer
+    VkBuffer handle = VK_NULL_HANDLE;
+
+    uint32_t vertex_capacity = 0;
+    uint32_t index_capacity = 0;
+
+    std::array<VkDeviceSize, MAX_STREAMS> stream_offsets = {}; // Start of each stream in the buffer, vertex i of stream s is at stream_offsets[s] + i * stride
+    VkDeviceSize index_offset = 0; // Start of the indices in the buffer
+
+    RangeList vertices;
+    RangeList indices;
+};
+
+// Meshes sharing a vertex layout and index type, sub-allocated from shared chunks so a single bind serves all of them
+// Bound buffers can't move, the arena grows by adding chunks twice as large as the last one
+struct MeshArena {
+    static constexpr uint32_t MIN_VERTICES = 1 << 16; // Vertices of the first chunk
+    static constexpr uint32_t MIN_INDICES = 3 << 16; // Indices of the first chunk
+
+    std::vector<uint32_t> strides; // Bytes per vertex of each stream
+    VkIndexType index_type = VK_INDEX_TYPE_MAX_ENUM; // VK_INDEX_TYPE_MAX_ENUM when the meshes are not indexed
+
+    std::vector<MeshArenaChunk> chunks;
+
+    bool matches(const std::vector<uint32_t> &strides, VkIndexType index_type) const;
+
+    // Reserve the vertex and index ranges of a mesh, a chunk is added when none has room
+    bool allocate(uint32_t vertex_count, uint32_t index_count, uint32_t &chunk, uint32_t &first_vertex, uint32_t &first_index);
+    void release(uint32_t chunk, uint32_t first_vertex, uint32_t vertex_count, uint32_t first_index, uint32_t index_count);
+
+    bool grow(uint32_t vertex_count, uint32_t index_count); // Add a chunk holding at least that many vertices and indices
+
+    static uint32_t index_size(VkIndexType type);
+};
+
+#endif // ALCHEMIST_SERVER_MESH_ARENA_HPP
@@ -0,0 +1,30 @@
+
+#ifndef ALCHEMIST_SERVER_MESH_OPTIMIZER_HPP
+#define ALCHEMIST_SERVER_MESH_OPTIMIZER_HPP
+
+#include <vector>
+#include <cstdint>
+
+struct VertexStream {
+    const uint8_t *data = nullptr;
+    uint32_t stride = 0; // Bytes per vertex
+};
+
+// Index rewriting passes run by MeshBuilder::set_optimized, in this order
+// Indices are always 32 bit here, MeshBuilder narrows them once the final vertex count is known
+
+// Point every index at the first vertex holding the same bytes in all streams, the copies become unused
+void deduplicate_vertices(std::vector<uint32_t> &indices, const std::vector<VertexStream> &streams, uint32_t vertex_count);
+
+// Reorder the triangles of a triangle list for a post transform cache of cache_size entries (Tipsify, Sander et al. 2007)
+void optimize_vertex_cache(std::vector<uint32_t> &indices, uint32_t vertex_count, uint32_t cache_size = 16);
+
+// Sort the clusters between cache flushes of a triangle list so outward facing ones are drawn first, each cluster keeps its order
+// positions holds one vec3 of 32 bit floats per vertex
+void optimize_overdraw(std::vector<uint32_t> &indices, const VertexStream &positions, uint32_t vertex_count, uint32_t cache_size = 16);
+
+// Renumber the vertices in order of first use so vertex fetch walks memory forward, unused vertices are dropped
+// order[new vertex] = old vertex, returns the number of vertices left
+uint32_t optimize_vertex_fetch(std::vector<uint32_t> &indices, uint32_t vertex_count, std::vector<uint32_t> &order);
+
+#endif // ALCHEMIST_SERVER_MESH_OPTIMIZER_HPP
@@ -2,69 +2,70 @@
 #ifndef ALCHEMIST_SERVER_PIPELINE_HPP
 #define ALCHEMIST_SERVER_PIPELINE_HPP
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
+#include <type_traits>
 
 #include <vulkan/vulkan.h>
 
 #include "server/rid.hpp"
-
-#include "math/vector/vec2.hpp"
-#include "math/vector/vec3.hpp"
-#include "math/vector/vec4.hpp"
-
-template <typename T>
-struct VertexInputFormat;
-
-template <>
-struct VertexInputFormat<float> {
-    static constexpr VkFormat format = VK_FORMAT_R32_SFLOAT; // Format for single float vertex attribute
-};
-
-template <>
-struct VertexInputFormat<uint32_t> {
-    static constexpr VkFormat format = VK_FORMAT_R32_UINT; // Format for single uint32_t vertex attribute
-};
-
-template <>
-struct VertexInputFormat<vec2> {
-    static constexpr VkFormat format = VK_FORMAT_R32G32_SFLOAT; // Format for vec2 vertex attribute
-};
-
-template <>
-struct VertexInputFormat<vec3> {
-    static constexpr VkFormat format = VK_FORMAT_R32G32B32_SFLOAT; // Format for vec3 vertex attribute
-};
-
-template <>
-struct VertexInputFormat<vec4> {
-    static constexpr VkFormat format = VK_FORMAT_R32G32B32A32_SFLOAT; // Format for vec4 vertex attribute
-};
+#include "memory/slot_map.hpp"
+#include "server/vertex.hpp"
+#include "memory/worker_pool.hpp"
 
 struct Pipeline {
     VkPipeline pipeline;
     RID rid = RID_INVALID; // Resource ID for the pipeline
     RID layout = RID_INVALID; // Resource ID for the pipeline layout
+    bool ready = true; // False while an async build is compiling it, see PipelineServer::wait
+    uint32_t references = 1; // Builds that resolved to this pipeline, each one frees it once
 
-    Pipeline() = default;
 };
 
 struct PipelineLayout {
     VkPipelineLayout layout; // Vulkan pipeline layout object
     RID rid = RID_INVALID; // Resource ID for the pipeline layout
+    uint32_t references = 1; // Builds that resolved to this layout, each one frees it once
 
-    PipelineLayout() = default;
 };
 
 struct PipelineBuilder;
 
+// Specialization constants of one shader stage, owned by the PipelineServer so they outlive async builds
+struct Specialization {
+    std::vector<VkSpecializationMapEntry> entries; // Constant ID -> range in data
+    std::vector<uint8_t> data; // Packed constant values
+    VkSpecializationInfo info = {}; // Points into entries and data, refreshed on every change
+};
+
 struct ShaderBuilder {
     VkPipelineShaderStageCreateInfo &stage_info; // Vulkan shader stage creation info
+    Specialization *specialization = nullptr; // Created by the first set_constant
 
     ShaderBuilder(VkPipelineShaderStageCreateInfo &info);
 
     ShaderBuilder &set_stage(VkShaderStageFlagBits stage);
     ShaderBuilder &set_module(RID module);
     ShaderBuilder &set_name(const char *name);
+
+    // Value of the constant_id = id specialization constant, setting an id again overwrites it
+    ShaderBuilder &set_constant(uint32_t id, const void *value, size_t size);
+
+    template <typename T>
+    requires std::is_trivially_copyable_v<T> && (sizeof(T) == 4 || sizeof(T) == 8)
+    ShaderBuilder &set_constant(uint32_t id, const T &value) {
+        return set_constant(id, &value, sizeof(T));
+    }
+
+    ShaderBuilder &set_constant(uint32_t id, bool value) {
+        VkBool32 flag = value ? VK_TRUE : VK_FALSE; // SPIR-V booleans are 32 bit
+        return set_constant(id, &flag, sizeof(flag));
+    }
 };
 
 struct VertexInput {
@@ -84,12 +85,27 @@ struct VertexInput {
         return add_binding(binding, sizeof(T), input_rate);
     }
 
+    // One tightly packed binding per input of a vertex shader, binding index = location
+    VertexInput &from_shader(RID shader);
+
     template <typename T>
     VertexInput &add_attribute(uint32_t location, uint32_t binding, uint32_t offset) {
         static_assert(std::is_standard_layout_v<T>, "T must be a standard layout type");
         return add_attribute(location, binding, VertexInputFormat<T>::format, offset);
     }
 
+    // One interleaved binding holding every attribute of the vertex, at consecutive locations
+    template <typename V>
+    requires InterleavedVertex<V>
+    VertexInput &add_vertex(uint32_t binding, uint32_t first_location = 0, VkVertexInputRate input_rate = VK_VERTEX_INPUT_RATE_VERTEX) {
+        using Attributes = typename V::Attributes;
+        add_binding(binding, Attributes::stride, input_rate);
+        for (uint32_t i = 0; i < Attributes::count; ++i) {
+            add_attribute(first_location + i, binding, Attributes::formats[i], Attributes::offsets[i]);
+        }
+        return *this; // Return the current instance for method chaining
+    }
+
     void build() const;
 };
 
@@ -157,12 +173,14 @@ struct PipelineLayoutServer;
 
 struct PipelineLayoutBuilder {
     std::vector<VkDescriptorSetLayout> set_layouts; // Vector of descriptor set layouts
+    std::vector<VkPushConstantRange> push_constants; // Push constant ranges
 
     PipelineLayoutServer &server;
 
     PipelineLayoutBuilder(PipelineLayoutServer &server);
 
     PipelineLayoutBuilder &add_layout(RID layout);
+    PipelineLayoutBuilder &add_push_constant(VkShaderStageFlags stages, uint32_t offset, uint32_t size);
 
     RID build() const;
 };
@@ -188,7 +206,10 @@ struct PipelineBuilder {
     PipelineBuilder &set_render_pass(RID render_pass);
     PipelineBuilder &set_subpass(uint32_t subpass);
 
+    bool check() const; // Layout and render pass are set
+
     RID build();
+    RID build_async(); // Compiled on a worker thread, the RID is usable once PipelineServer::wait returns
 };
 
 struct SimplePipelineBuilder {
@@ -207,11 +228,32 @@ struct SimplePipelineBuilder {
     SimplePipelineBuilder &set_layout(RID layout);
     SimplePipelineBuilder &set_render_pass(RID render_pass);
 
+    bool check() const; // Layout and render pass are set
+
     RID build();
+    RID build_async(); // Compiled on a worker thread, the RID is usable once PipelineServer::wait returns
+};
+
+// A compute pipeline is one shader stage and a layout
+struct ComputePipelineBuilder {
+    VkComputePipelineCreateInfo create_info; // Vulkan compute pipeline creation info, holds the stage by value
+
+    PipelineServer &server;
+
+    ComputePipelineBuilder(PipelineServer &server);
+
+    ShaderBuilder set_shader(RID module);
+    ComputePipelineBuilder &set_layout(RID layout);
+
+    bool check() const; // Layout and shader are set
+
+    RID build() const;
+    RID build_async() const; // Compiled on a worker thread, the RID is usable once PipelineServer::wait returns
 };
 
 struct PipelineLayoutServer {
-    std::vector<PipelineLayout> pipeline_layouts; // Vector to hold all pipeline layouts
+    SlotMap<PipelineLayout, RIDServer::PIPELINE_LAYOUT> pipeline_layouts; // Slot map holding all pipeline layouts
+    std::unordered_map<std::string, RID> layout_keys; // Canonical state key -> layout, identical layouts are created once
 
     VkDevice device; // Vulkan device
 
@@ -223,6 +265,8 @@ struct PipelineLayoutServer {
 
     PipelineLayoutBuilder new_pipeline_layout(); // Create a new pipeline layout builder
 
+    void free_pipeline_layout(RID rid); // Destroyed once every build that resolved to it has freed it
+
     const PipelineLayout &get_pipeline_layout(RID rid) const;
 
     static PipelineLayoutServer &instance();
@@ -230,18 +274,50 @@ struct PipelineLayoutServer {
 };
 
 struct PipelineServer {
-    std::vector<Pipeline> pipelines;
+    SlotMap<Pipeline, RIDServer::PIPELINE> pipelines; // Slot map holding all pipelines
+    std::unordered_map<std::string, RID> pipeline_keys; // Canonical state key -> pipeline, identical pipelines are compiled once
+    std::deque<Specialization> specializations; // Deque so the stages can point into it
 
     VkDevice device; // Vulkan device
+    VkPhysicalDevice physical_device; // Vulkan physical device, identifies whose cache blob is on disk
+
+    VkPipelineCache cache = VK_NULL_HANDLE; // Shared by every pipeline creation
+    std::string cache_path; // Cache file, empty to keep the cache in memory only
+
+    PipelineServer(VkDevice device, VkPhysicalDevice physical_device, const char *cache_path = nullptr);
+    ~PipelineServer(); // Saves the cache before destroying it
 
-    PipelineServer(VkDevice device);
-    ~PipelineServer();
+    bool load_cache(std::vector<uint8_t> &data) const; // Read the cache file, false if missing or made by another device or driver
+    bool save_cache() const; // Write the cache file, also done on destruction
+
+    WorkerPool workers; // Compiles the async builds
+    std::mutex compile_mutex; // Guards the pipelines still compiling
+    std::condition_variable compiled; // Signaled every time an async build finishes
 
     RID new_pipeline(const VkGraphicsPipelineCreateInfo &create_info);
     RID new_pipeline(VkGraphicsPipelineCreateInfo &&create_info);
 
+    // Reserve the RID now and compile on a worker, the stages are copied since the builder may not outlive the job
+    // Every other state pointed to by create_info must stay alive until the pipeline is ready
+    RID new_pipeline_async(const VkGraphicsPipelineCreateInfo &create_info, std::vector<VkPipelineShaderStageCreateInfo> stages);
+
+    static std::string pipeline_key(const VkGraphicsPipelineCreateInfo &create_info, const VkPipelineShaderStageCreateInfo *stages, uint32_t stage_count);
+    static std::string compute_pipeline_key(const VkComputePipelineCreateInfo &create_info);
+    RID find_pipeline(const std::string &key) const; // RID_INVALID if no identical pipeline exists
+    RID share_pipeline(const std::string &key); // find_pipeline, counting one more user of the pipeline found
+    RID compile_async(std::string key, std::function<VkResult(VkPipeline &)> compile); // Reserve a not ready pipeline and run compile on a worker
+
+    bool is_ready(RID rid);
+    void wait(RID rid); // Block until the pipeline is compiled, its handle is null if the compilation failed
+    void free_pipeline(RID rid); // Deduplicated builds share the RID, destroyed by the last free, the GPU must be done with it
+    void wait_all(); // Block until every async build is compiled
+
+    RID new_compute_pipeline(const VkComputePipelineCreateInfo &create_info);
+    RID new_compute_pipeline_async(const VkComputePipelineCreateInfo &create_info);
+
     PipelineBuilder new_pipeline(); // Create a new pipeline builder
     SimplePipelineBuilder new_simple_pipeline(); // Create a new simple pipeline builder
+    ComputePipelineBuilder new_compute_pipeline(); // Create a new compute pipeline builder
 
     Pipeline &get_pipeline(RID rid);
     const Pipeline &get_pipeline(RID rid) const;
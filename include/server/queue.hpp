@@ -7,52 +7,51 @@
 #include <vulkan/vulkan.h>
 
 #include "server/rid.hpp"
+#include "memory/slot_map.hpp"
 
-struct CommandBuffer;
-
-struct Submit {
-    VkQueue queue;
-    std::vector<VkCommandBuffer> command_buffers; // Vector to hold command buffers
-    std::vector<VkSemaphore> wait_semaphores; // Optional wait semaphores
-    std::vector<VkPipelineStageFlags> wait_stages; // Optional wait stages
-    std::vector<VkSemaphore> signal_semaphores; // Optional signal semaphores
-
-    Submit(VkQueue queue);
-    Submit(Submit &&other);
-
-    ~Submit();
+#include "vulkan/sync.hpp"
 
-    void wait() const;
-};
+struct CommandBuffer;
 
 struct SubmitBuilder {
     VkQueue queue;
+    VkDevice device; // Vulkan device, needed by the returned future
+    VkSemaphore timeline; // Timeline semaphore of the queue, null if the queue has none
+    uint64_t *timeline_value; // Last value signaled on the timeline, owned by the queue
+
     std::vector<VkCommandBuffer> command_buffers; // Vector to hold command buffers
     std::vector<VkSemaphore> wait_semaphores; // Optional wait semaphores
     std::vector<VkPipelineStageFlags> wait_stages; // Optional wait stages
+    std::vector<uint64_t> wait_values; // Timeline values to wait for, ignored for binary semaphores
     std::vector<VkSemaphore> signal_semaphores; // Optional signal semaphores
+    std::vector<uint64_t> signal_values; // Timeline values to signal, ignored for binary semaphores
 
-    SubmitBuilder(VkQueue queue);
+    SubmitBuilder(VkQueue queue, VkDevice device = VK_NULL_HANDLE, VkSemaphore timeline = VK_NULL_HANDLE, uint64_t *timeline_value = nullptr);
 
     SubmitBuilder &add_command_buffer(const CommandBuffer &buffer);
     SubmitBuilder &add_wait_semaphore(VkSemaphore semaphore, VkPipelineStageFlags stage);
+    SubmitBuilder &add_wait(const GpuFuture &future, VkPipelineStageFlags stage); // Chain after another submission, on any queue
     SubmitBuilder &add_signal_semaphore(VkSemaphore semaphore);
 
-    Submit submit(VkFence fence = VK_NULL_HANDLE);
+    GpuFuture submit(VkFence fence = VK_NULL_HANDLE); // Completes when the queue timeline reaches the value of this submission
 };
 
 struct Queue {
     VkQueue queue; // Vulkan queue object
+    VkDevice device = VK_NULL_HANDLE; // Vulkan device
+    VkSemaphore timeline = VK_NULL_HANDLE; // Signaled by every submission made through this queue
+    mutable uint64_t timeline_value = 0; // Value of the last submission, bumped by the submit builders
     RID rid = RID_INVALID; // Resource ID for the queue
 
     Queue() = default;
 
     SubmitBuilder submit() const;
-    void wait() const;
+    GpuFuture last() const; // Future of the last submission made through this queue
+    void wait() const; // Wait for the submissions made through this queue, not the whole VkQueue
 };
 
 struct QueueServer {
-    std::vector<Queue> queues; // Vector to hold all queues
+    SlotMap<Queue, RIDServer::QUEUE> queues; // Slot map holding all queues
 
     VkDevice device; // Vulkan device
 
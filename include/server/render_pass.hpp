@@ -5,6 +5,7 @@
 #include <vulkan/vulkan.h>
 
 #include "server/rid.hpp"
+#include "memory/slot_map.hpp"
 #include "vulkan/command_buffer.hpp"
 #include "graphics/color.hpp"
 
@@ -23,7 +24,7 @@ struct RenderPassBegin {
     RenderPassBegin &add_clear_color(const color &value);
     RenderPassBegin &add_clear_depth(float value); 
 
-    void begin();
+    void begin(VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE); // Secondary buffers need VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
     void end();
 };
 
@@ -125,7 +126,7 @@ struct RenderingPassBuilder {
 };
 
 struct RenderPassServer {
-    std::vector<RenderPass> render_passes; // Vector to hold all buffers
+    SlotMap<RenderPass, RIDServer::RENDER_PASS> render_passes; // Slot map holding all render passes
 
     VkDevice device; // Vulkan device
 
@@ -2,10 +2,6 @@
 #ifndef ALCHEMIST_MEMORY_RID_HPP
 #define ALCHEMIST_MEMORY_RID_HPP
 
-#include <vector>
-#include <stack>
-#include <set>
-
 #include <cstdint>
 #include <memory>
 
@@ -13,39 +9,48 @@ typedef uint64_t RID; // Resource ID type, typically used for identifying resour
 
 constexpr RID RID_INVALID = UINT64_MAX; // Invalid RID value, used to indicate an uninitialized or invalid resource ID
 
-struct RIDServer {
-    std::vector<RID> next;
-    std::vector<std::stack<RID>> stack;
-    std::vector<std::set<RID>> in_stack; // Set to track used RIDs for each type
-
-    RIDServer();
-    ~RIDServer() = default;
-
-    RID new_id(RID type);
-    void free(RID type, RID id);
-
-    static const RID MEMORY = 0; // Resource ID for memory management
-    static const RID BIND = 1; // Resource ID for binding resources
-    static const RID IMAGE = 2; // Resource ID for images
-    static const RID BUFFER = 3; // Resource ID for buffers
-    static const RID MESH = 4; // Resource ID for meshes
-    static const RID RENDER_PASS = 5; // Resource ID for render passes
-    static const RID COMMAND_POOL = 6; // Resource ID for command pools
-    static const RID QUEUE = 7; // Resource ID for queues
-    static const RID PIPELINE = 8; // Resource ID for pipelines
-    static const RID FRAMEBUFFER = 9; // Resource ID for framebuffers
-    static const RID DESCRIPTOR_LAYOUT = 11; // Resource ID for descriptor layouts
-    static const RID DESCRIPTOR_SET = 11; // Resource ID for descriptor sets
-    static const RID DESCRIPTOR_POOL = 12; // Resource ID for descriptor pools
-    static const RID PIPELINE_LAYOUT = 13; // Resource ID for pipeline layouts
-    static const RID SHADER = 14; // Resource ID for shaders
-    static const RID IMAGE_VIEW = 15; // Resource ID for image views
-    static const RID SAMPLER = 16; // Resource ID for samplers
-
-
-    static RIDServer &instance();
-    static std::unique_ptr<RIDServer> __instance; // Unique pointer to the RIDServer instance
-};
+// RID layout: | type (8 bits) | generation (24 bits) | index (32 bits) |
+constexpr RID RID_INDEX_BITS = 32; // Bits used by the slot index
+constexpr RID RID_GENERATION_BITS = 24; // Bits used by the slot generation
+constexpr RID RID_GENERATION_MASK = (RID(1) << RID_GENERATION_BITS) - 1; // Mask of the generation bits
+
+constexpr RID rid_make(RID type, RID generation, RID index) {
+    return (type << (RID_INDEX_BITS + RID_GENERATION_BITS)) | ((generation & RID_GENERATION_MASK) << RID_INDEX_BITS) | (index & UINT32_MAX);
+}
+
+constexpr uint32_t rid_index(RID rid) {
+    return rid & UINT32_MAX; // Slot index of the RID
+}
+
+constexpr uint32_t rid_generation(RID rid) {
+    return (rid >> RID_INDEX_BITS) & RID_GENERATION_MASK; // Slot generation of the RID
+}
+
+constexpr RID rid_type(RID rid) {
+    return rid >> (RID_INDEX_BITS + RID_GENERATION_BITS); // Resource type of the RID
+}
+
+// RIDs are handed out by the SlotMap of each server, only the resource types are left here
+namespace RIDServer {
+    constexpr RID MEMORY = 0; // Resource ID for memory management
+    constexpr RID BIND = 1; // Resource ID for binding resources
+    constexpr RID IMAGE = 2; // Resource ID for images
+    constexpr RID BUFFER = 3; // Resource ID for buffers
+    constexpr RID MESH = 4; // Resource ID for meshes
+    constexpr RID RENDER_PASS = 5; // Resource ID for render passes
+    constexpr RID COMMAND_POOL = 6; // Resource ID for command pools
+    constexpr RID QUEUE = 7; // Resource ID for queues
+    constexpr RID PIPELINE = 8; // Resource ID for pipelines
+    constexpr RID FRAMEBUFFER = 9; // Resource ID for framebuffers
+    constexpr RID IMAGE_MEMORY = 10; // Resource ID for image memory blocks
+    constexpr RID DESCRIPTOR_LAYOUT = 11; // Resource ID for descriptor layouts
+    constexpr RID DESCRIPTOR_POOL = 12; // Resource ID for descriptor pools
+    constexpr RID PIPELINE_LAYOUT = 13; // Resource ID for pipeline layouts
+    constexpr RID SHADER = 14; // Resource ID for shaders
+    constexpr RID IMAGE_VIEW = 15; // Resource ID for image views
+    constexpr RID SAMPLER = 16; // Resource ID for samplers
+    constexpr RID DESCRIPTOR_SET = 17; // Resource ID for descriptor sets
+}
 
 // struct RIDAtlas {
 //     RID MEMORY;
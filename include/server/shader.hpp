@@ -2,21 +2,77 @@
 #ifndef ALCHEMIST_SERVER_SHADER_HPP
 #define ALCHEMIST_SERVER_SHADER_HPP
 
+#include <string>
 #include <vector>
+#include <memory>
 
 #include <vulkan/vulkan.h>
 
 #include "server/rid.hpp"
+#include "server/shader_reflection.hpp"
+#include "memory/slot_map.hpp"
 
 struct Shader {
     VkShaderModule shader_module; // Vulkan shader module object
     RID rid = RID_INVALID; // Resource ID for the shader
+    ShaderReflection reflection; // Bindings, push constants and inputs read from the SPIR-V
 
     Shader() = default;
 };
 
+// Entry of the archive index, written by pack_shaders.py
+struct ShaderArchiveEntry {
+    uint64_t name_hash; // FNV-1a 64 of the file name
+    uint64_t offset; // Offset of the SPIR-V blob from the start of the archive
+    uint64_t size; // Size of the SPIR-V blob in bytes
+};
+
+// Read-only mapping of a packed shader archive
+struct ShaderArchive {
+    static constexpr uint32_t MAGIC = 0x50534C41; // "ALSP"
+    static constexpr uint32_t VERSION = 1;
+
+    const uint8_t *data = nullptr; // Start of the mapping
+    size_t size = 0; // Size of the mapping in bytes
+    std::vector<uint8_t> fallback; // Owns the bytes when the file could not be mapped
+
+    const ShaderArchiveEntry *entries = nullptr; // Index, sorted by name hash
+    uint32_t entry_count = 0;
+
+    bool open(const char *file_path);
+    void close();
+
+    const ShaderArchiveEntry *find(const char *name) const; // Binary search on the name hash, nullptr if missing
+};
+
+// Layouts derived from the reflection of a set of shaders
+// Identical interfaces give the same RIDs, so descriptor sets bound for one pipeline stay valid across pipelines sharing it
+struct ShaderLayout {
+    std::vector<RID> set_layouts; // Descriptor set layout of each set, empty sets included
+    RID pipeline_layout = RID_INVALID; // Pipeline layout made of set_layouts and the push constant ranges
+};
+
+struct ShaderServer;
+
+struct ShaderLayoutBuilder {
+    std::vector<ReflectedBinding> bindings; // Merged bindings of every shader, sorted by set then binding
+    std::vector<VkPushConstantRange> push_constants; // One range per stage
+
+    ShaderServer &server;
+
+    ShaderLayoutBuilder(ShaderServer &server);
+
+    ShaderLayoutBuilder &add_shader(RID shader); // Merge the interface of a shader, stages sharing a binding are OR'ed together
+    ShaderLayoutBuilder &set_dynamic(uint32_t set, uint32_t binding); // Dynamic offsets cannot be expressed in SPIR-V
+
+    ShaderLayout build() const;
+};
+
 struct ShaderServer {
-    std::vector<Shader> shaders; // Vector to hold all shaders
+    SlotMap<Shader, RIDServer::SHADER> shaders; // Slot map holding all shaders
+
+    ShaderArchive archive; // Packed shaders, empty until open_archive
+    std::string loose_directory; // Where the shaders missing from the archive are read from, ends with a separator
 
     VkDevice device; // Vulkan device
 
@@ -28,6 +84,11 @@ struct ShaderServer {
 
     RID from_file(const char *file_path);
 
+    bool open_archive(const char *file_path, const char *loose_directory); // Map a shaders.pak built by pack_shaders.py, the loose files are used even if this fails
+    RID from_archive(const char *name); // Create the module straight from the mapping, falls back to the loose file
+
+    ShaderLayoutBuilder new_layout(); // Create a layout builder fed by shader reflection
+
     const Shader &get_shader(RID rid) const;
 
     static ShaderServer &instance();
@@ -0,0 +1,38 @@
+
+#ifndef ALCHEMIST_SERVER_SHADER_REFLECTION_HPP
+#define ALCHEMIST_SERVER_SHADER_REFLECTION_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+struct ReflectedBinding {
+    uint32_t set = 0; // layout(set = N)
+    uint32_t binding = 0; // layout(binding = N)
+    VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM; // Uniform buffers are never dynamic in SPIR-V, see ShaderLayoutBuilder::set_dynamic
+    uint32_t count = 1; // Array length, runtime arrays count as 1
+    VkShaderStageFlags stages = 0; // Stages reading the binding
+};
+
+struct ReflectedInput {
+    uint32_t location = 0; // layout(location = N)
+    VkFormat format = VK_FORMAT_UNDEFINED; // 32 bit scalar or vector format of the input
+};
+
+// Interface of a SPIR-V module, read from its decorations when the module is created
+struct ShaderReflection {
+    VkShaderStageFlagBits stage = VK_SHADER_STAGE_ALL; // Stage of the first entry point
+    std::string entry_point; // Name of the first entry point
+
+    std::vector<ReflectedBinding> bindings; // Descriptor bindings, sorted by set then binding
+    std::vector<ReflectedInput> inputs; // Vertex stage inputs, sorted by location, built-ins excluded
+    VkPushConstantRange push_constant = {}; // Push constant block, size 0 when the stage has none
+
+    bool reflect(const uint32_t *code, size_t size); // size in bytes, false if the module is not valid SPIR-V
+};
+
+uint32_t format_size(VkFormat format); // Size in bytes of the formats produced by the reflection, 0 otherwise
+
+#endif // ALCHEMIST_SERVER_SHADER_REFLECTION_HPP
@@ -0,0 +1,66 @@
+
+#ifndef ALCHEMIST_SERVER_STAGING_HPP
+#define ALCHEMIST_SERVER_STAGING_HPP
+
+#include <deque>
+#include <vector>
+#include <utility>
+
+#include <vulkan/vulkan.h>
+
+#include "server/rid.hpp"
+
+#include "vulkan/sync.hpp"
+
+struct StagingRegion {
+    VkBuffer buffer = VK_NULL_HANDLE; // Ring buffer the region lives in, null if the allocation failed
+    VkDeviceSize offset = 0; // Offset of the region in the ring buffer
+    void *data = nullptr; // Persistently mapped pointer to the region
+};
+
+// Host visible ring buffer shared by every upload of a server
+// Regions are handed out front to back and retired in bulk once the submit that consumed them completes
+struct StagingRing {
+    struct InFlight {
+        GpuFuture done; // Completion of the submit reading these regions
+        VkDeviceSize end; // Head of the ring when the regions were sealed, becomes the tail once retired
+        VkBuffer buffer; // Ring buffer the regions were taken from
+        std::vector<std::pair<VkBuffer, RID>> retired; // Ring buffers replaced by a grow, destroyed with this batch
+    };
+
+    VkDevice device; // Vulkan device
+    VkPhysicalDevice physical_device; // Vulkan physical device
+
+    VkBuffer buffer = VK_NULL_HANDLE; // Ring buffer, created on the first allocation
+    RID memory_rid = RID_INVALID; // GPU memory block backing the ring
+    uint8_t *mapped = nullptr; // Mapped for the whole lifetime of the ring
+
+    VkDeviceSize capacity; // Size of the ring in bytes
+    VkDeviceSize head = 0; // Next free byte
+    VkDeviceSize tail = 0; // Oldest byte still read by the GPU
+
+    bool pending = false; // Regions of the current buffer were handed out since the last seal
+    std::vector<std::pair<VkBuffer, RID>> retired; // Ring buffers replaced by a grow, wait for the next seal
+
+    std::deque<InFlight> in_flight; // Sealed batches, oldest first
+
+    static constexpr VkDeviceSize DEFAULT_CAPACITY = 64 * 1024 * 1024; // 64 MiB
+
+    StagingRing(VkDevice device, VkPhysicalDevice physical_device, VkDeviceSize capacity = DEFAULT_CAPACITY);
+    ~StagingRing();
+
+    StagingRegion allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+
+    // Every region handed out since the last seal is read by the submission behind done
+    void seal(const GpuFuture &done);
+
+    void reclaim(); // Retire the batches whose submission has completed
+    void wait_idle(); // Block until every sealed batch is retired
+
+    bool create(VkDeviceSize size);
+    void destroy(VkBuffer ring, RID memory);
+    bool live() const; // Regions of the current buffer are pending or in flight
+    VkDeviceSize find_space(VkDeviceSize size, VkDeviceSize alignment) const;
+};
+
+#endif // ALCHEMIST_SERVER_STAGING_HPP
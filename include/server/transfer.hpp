@@ -0,0 +1,60 @@
+
+#ifndef ALCHEMIST_SERVER_TRANSFER_HPP
+#define ALCHEMIST_SERVER_TRANSFER_HPP
+
+#include <deque>
+#include <vector>
+#include <memory>
+
+#include <vulkan/vulkan.h>
+
+#include "server/rid.hpp"
+#include "server/queue.hpp"
+
+#include "vulkan/command_buffer.hpp"
+
+struct TransferBatch {
+    CommandBuffer cmd_buffer; // Transfer command buffer, reused once the batch retires
+    VkSemaphore semaphore = VK_NULL_HANDLE; // Signaled by the transfer submit, waited on by the graphics submit
+    GpuFuture done; // Completion of the transfer submit
+    VkFence consumer = VK_NULL_HANDLE; // Frame fence of the graphics submit that waited on the semaphore
+
+    std::vector<VkBufferMemoryBarrier> buffer_acquires; // Acquire half of the buffer ownership transfers
+    std::vector<VkImageMemoryBarrier> image_acquires; // Acquire half of the image ownership transfers
+
+    bool acquired = false; // A graphics submit waits on the semaphore
+};
+
+// Runs the BufferServer and ImageServer commands on the transfer queue
+// Ownership moves from the transfer family to the graphics family and the first graphics submit after a flush waits on it
+// Concurrent buffers, like the mesh arena chunks, are used by both families and skip the ownership transfer
+struct TransferServer {
+    std::deque<TransferBatch> batches; // Submitted batches, oldest first
+    std::vector<TransferBatch> free_batches; // Retired batches, ready to be reused
+
+    VkDevice device; // Vulkan device
+
+    RID queue; // Transfer queue
+    RID command_pool; // Command pool on the transfer queue family
+
+    uint32_t src_family; // Transfer queue family index
+    uint32_t dst_family; // Graphics queue family index
+
+    static constexpr VkPipelineStageFlags CONSUMER_STAGES = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT; // Stages reading uploaded data
+
+    TransferServer(VkDevice device, RID queue, RID command_pool, uint32_t src_family, uint32_t dst_family);
+    ~TransferServer();
+
+    bool flush(); // Submit the pending buffer and image commands, false if there was nothing to submit
+
+    // Record the acquire barriers of every flushed batch into a graphics command buffer and make the submit wait on them
+    void acquire(VkCommandBuffer cmd_buffer, SubmitBuilder &submit, VkFence frame_fence);
+
+    void collect(); // Recycle the batches the GPU is done with
+    void wait_idle(); // Block until every flushed batch has been executed
+
+    static TransferServer &instance();
+    static std::unique_ptr<TransferServer> __instance; // Singleton instance of TransferServer
+};
+
+#endif // ALCHEMIST_SERVER_TRANSFER_HPP
@@ -0,0 +1,204 @@
+
+#ifndef ALCHEMIST_SERVER_VERTEX_HPP
+#define ALCHEMIST_SERVER_VERTEX_HPP
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include <vulkan/vulkan.h>
+
+#include "math/vector/vec2.hpp"
+#include "math/vector/vec3.hpp"
+#include "math/vector/vec4.hpp"
+
+// Packed attribute types, the vertex fetch unit expands them to floats
+struct half2 {
+    uint16_t x, y; // IEEE 754 half floats
+};
+
+struct half4 {
+    uint16_t x, y, z, w; // IEEE 754 half floats, 3 component 16 bit formats are rarely supported for vertices
+};
+
+struct unorm8x4 {
+    uint8_t x, y, z, w; // [0, 1] as [0, 255]
+};
+
+uint16_t encode_half(float value); // Round to nearest even, out of range values become infinities
+half2 encode_half2(const vec2 &value);
+half4 encode_half4(const vec3 &value, float w = 1.0f);
+unorm8x4 encode_unorm8(const vec3 &color, float alpha = 1.0f);
+
+template <typename T>
+struct VertexInputFormat;
+
+template <>
+struct VertexInputFormat<float> {
+    static constexpr VkFormat format = VK_FORMAT_R32_SFLOAT; // Format for single float vertex attribute
+};
+
+template <>
+struct VertexInputFormat<uint32_t> {
+    static constexpr VkFormat format = VK_FORMAT_R32_UINT; // Format for single uint32_t vertex attribute
+};
+
+template <>
+struct VertexInputFormat<vec2> {
+    static constexpr VkFormat format = VK_FORMAT_R32G32_SFLOAT; // Format for vec2 vertex attribute
+};
+
+template <>
+struct VertexInputFormat<vec3> {
+    static constexpr VkFormat format = VK_FORMAT_R32G32B32_SFLOAT; // Format for vec3 vertex attribute
+};
+
+template <>
+struct VertexInputFormat<vec4> {
+    static constexpr VkFormat format = VK_FORMAT_R32G32B32A32_SFLOAT; // Format for vec4 vertex attribute
+};
+
+template <>
+struct VertexInputFormat<half2> {
+    static constexpr VkFormat format = VK_FORMAT_R16G16_SFLOAT;
+};
+
+template <>
+struct VertexInputFormat<half4> {
+    static constexpr VkFormat format = VK_FORMAT_R16G16B16A16_SFLOAT;
+};
+
+template <>
+struct VertexInputFormat<unorm8x4> {
+    static constexpr VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+};
+
+template <typename T>
+struct MemberPointer;
+
+template <typename C, typename M>
+struct MemberPointer<M C::*> {
+    using Class = C;
+    using Member = M;
+};
+
+// Attributes of an interleaved vertex struct, every member listed in declaration order, locations follow the list
+// struct Vertex { vec3 position; vec3 normal; using Attributes = VertexAttributes<&Vertex::position, &Vertex::normal>; };
+template <auto First, auto... Rest>
+struct VertexAttributes {
+    using Vertex = typename MemberPointer<decltype(First)>::Class;
+
+    static constexpr uint32_t count = 1 + sizeof...(Rest);
+
+    static constexpr std::array<VkFormat, count> formats = {
+        VertexInputFormat<typename MemberPointer<decltype(First)>::Member>::format,
+        VertexInputFormat<typename MemberPointer<decltype(Rest)>::Member>::format...
+    };
+
+    static constexpr std::array<uint32_t, count> sizes = {
+        sizeof(typename MemberPointer<decltype(First)>::Member),
+        sizeof(typename MemberPointer<decltype(Rest)>::Member)...
+    };
+
+    static constexpr std::array<uint32_t, count> alignments = {
+        alignof(typename MemberPointer<decltype(First)>::Member),
+        alignof(typename MemberPointer<decltype(Rest)>::Member)...
+    };
+
+    // Offsets can't be read from member pointers at compile time, they are laid out like the compiler does for a standard layout struct
+    static constexpr std::array<uint32_t, count> offsets = []() {
+        std::array<uint32_t, count> offsets = {};
+        uint32_t end = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            offsets[i] = (end + alignments[i] - 1) / alignments[i] * alignments[i];
+            end = offsets[i] + sizes[i];
+        }
+        return offsets;
+    }();
+
+    static constexpr uint32_t stride = sizeof(Vertex);
+
+    static_assert(std::is_standard_layout_v<Vertex>, "Vertex must be a standard layout type");
+    static_assert((std::is_same_v<typename MemberPointer<decltype(Rest)>::Class, Vertex> && ...), "Attributes must belong to the same vertex");
+    static_assert((offsets[count - 1] + sizes[count - 1] + alignof(Vertex) - 1) / alignof(Vertex) * alignof(Vertex) == sizeof(Vertex),
+        "Attributes must list every member of the vertex in declaration order");
+
+    // Copy the element index of one array per attribute into a vertex, to interleave separate streams
+    template <typename... Streams>
+    static void gather(Vertex &vertex, uint64_t index, const Streams *...streams) {
+        static_assert(sizeof...(Streams) == count, "One stream per attribute");
+        gather_members<First, Rest...>(vertex, index, streams...);
+    }
+
+    template <auto Member, auto... Members, typename Stream, typename... Streams>
+    static void gather_members(Vertex &vertex, uint64_t index, const Stream *stream, const Streams *...streams) {
+        vertex.*Member = stream[index];
+        if constexpr (sizeof...(Members) > 0) {
+            gather_members<Members...>(vertex, index, streams...);
+        }
+    }
+};
+
+template <typename V>
+concept InterleavedVertex = requires {
+    typename V::Attributes;
+    requires std::is_same_v<typename V::Attributes::Vertex, V>;
+};
+
+// Format of the first attribute of a stream of T, VK_FORMAT_UNDEFINED when T is not a known attribute
+template <typename T>
+constexpr VkFormat first_attribute_format() {
+    if constexpr (InterleavedVertex<T>) {
+        return T::Attributes::formats[0];
+    } else if constexpr (requires { VertexInputFormat<T>::format; }) {
+        return VertexInputFormat<T>::format;
+    } else {
+        return VK_FORMAT_UNDEFINED;
+    }
+}
+
+// Quantized forms of the vertices below, half the size, built by MeshBuilder::set_quantized
+// Read as floats by the same shaders as the full precision vertex
+// Normals are left out until a shader can decode a packed form
+struct QuantizedPositionColorVertex {
+    half4 position;
+    unorm8x4 color;
+
+    using Attributes = VertexAttributes<&QuantizedPositionColorVertex::position, &QuantizedPositionColorVertex::color>;
+};
+
+struct PositionColorVertex {
+    vec3 position;
+    vec3 color;
+
+    using Attributes = VertexAttributes<&PositionColorVertex::position, &PositionColorVertex::color>;
+};
+
+struct PositionNormalVertex {
+    vec3 position;
+    vec3 normal;
+
+    using Attributes = VertexAttributes<&PositionNormalVertex::position, &PositionNormalVertex::normal>;
+};
+
+struct PositionNormalUvVertex {
+    vec3 position;
+    vec3 normal;
+    vec2 uv;
+
+    using Attributes = VertexAttributes<&PositionNormalUvVertex::position, &PositionNormalUvVertex::normal, &PositionNormalUvVertex::uv>;
+};
+
+QuantizedPositionColorVertex quantize(const PositionColorVertex &vertex);
+
+template <typename V>
+concept QuantizableVertex = InterleavedVertex<V> && requires(const V &vertex) {
+    { quantize(vertex) } -> InterleavedVertex;
+};
+
+template <typename V>
+requires QuantizableVertex<V>
+using QuantizedVertex = decltype(quantize(std::declval<const V &>())); // Layout to give VertexInput::add_vertex for quantized meshes
+
+#endif // ALCHEMIST_SERVER_VERTEX_HPP
@@ -0,0 +1,45 @@
+
+#ifndef ALCHEMIST_VULKAN_PARALLEL_RECORDER_HPP
+#define ALCHEMIST_VULKAN_PARALLEL_RECORDER_HPP
+
+#include <functional>
+#include <vector>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "server/rid.hpp"
+#include "memory/worker_pool.hpp"
+#include "vulkan/command_buffer.hpp"
+#include "vulkan/recorder.hpp"
+
+// Records a render pass as secondary command buffers on a worker pool, then executes them from the primary
+// Every worker thread owns a command pool per frame in flight, so no pool is ever used by two threads at once
+struct ParallelRecorder {
+    // Called on a worker with the recorder of its secondary buffer and its job index
+    // Dynamic state is not inherited by secondary buffers, the job must set its viewport and scissor
+    using Job = std::function<void(CommandRecorder &recorder, uint32_t job)>;
+
+    WorkerPool workers;
+
+    std::vector<std::vector<RID>> frames; // Transient command pool of each thread, [frame in flight][thread]
+    std::vector<VkCommandBuffer> secondaries; // Buffers of the current record call, in job order
+    std::vector<RecorderStats> job_stats; // Written by each job, summed into the primary once they are done
+
+    uint32_t frame = 0; // Frame in flight being recorded
+
+    ParallelRecorder(uint32_t frames_in_flight, uint32_t queue_family_index, uint32_t thread_count = 0);
+
+    ParallelRecorder(const ParallelRecorder &) = delete;
+    ParallelRecorder &operator=(const ParallelRecorder &) = delete;
+
+    void begin_frame(uint32_t flight_frame); // Reset the pools of the frame, its fence must have signaled
+
+    // Record job_count secondary buffers inside the current subpass of the primary, which must have begun the render pass
+    // with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, and execute them in job order
+    void record(CommandRecorder &primary, RID render_pass, RID framebuffer, uint32_t subpass, uint32_t job_count, const Job &job);
+
+    uint32_t thread_count() const;
+};
+
+#endif // ALCHEMIST_VULKAN_PARALLEL_RECORDER_HPP
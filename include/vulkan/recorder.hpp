@@ -0,0 +1,83 @@
+
+#ifndef ALCHEMIST_VULKAN_RECORDER_HPP
+#define ALCHEMIST_VULKAN_RECORDER_HPP
+
+#include <array>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "server/rid.hpp"
+
+struct Mesh;
+
+struct RecorderStats {
+    uint32_t emitted = 0; // Commands written to the command buffer
+    uint32_t skipped = 0; // Calls dropped because the state was already bound
+};
+
+// Wraps a command buffer and remembers the state bound through it, calls that would not change anything are dropped
+// The tracked state is only valid for commands recorded through the recorder, call invalidate() after recording around it
+struct CommandRecorder {
+    static constexpr uint32_t MAX_BOUND_SETS = 4; // Sets tracked per bind point
+    static constexpr uint32_t MAX_DYNAMIC_OFFSETS = 4; // Dynamic offsets tracked per set, sets with more are always rebound
+    static constexpr uint32_t MAX_VERTEX_BINDINGS = 16; // Vertex buffer bindings tracked
+
+    struct BoundSet {
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        uint32_t offset_count = 0;
+        std::array<uint32_t, MAX_DYNAMIC_OFFSETS> offsets = {};
+    };
+
+    struct BindPointState {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkPipelineLayout layout = VK_NULL_HANDLE; // Layout the tracked sets were bound with
+        std::array<BoundSet, MAX_BOUND_SETS> sets = {};
+    };
+
+    VkCommandBuffer buffer = VK_NULL_HANDLE;
+
+    BindPointState graphics;
+    BindPointState compute;
+
+    std::array<VkBuffer, MAX_VERTEX_BINDINGS> vertex_buffers = {};
+    std::array<VkDeviceSize, MAX_VERTEX_BINDINGS> vertex_offsets = {};
+
+    VkBuffer index_buffer = VK_NULL_HANDLE;
+    VkDeviceSize index_offset = 0;
+    VkIndexType index_type = VK_INDEX_TYPE_MAX_ENUM;
+
+    VkViewport bound_viewport = {};
+    VkRect2D bound_scissor = {};
+    bool has_viewport = false;
+    bool has_scissor = false;
+
+    RecorderStats stats;
+
+    CommandRecorder() = default;
+    CommandRecorder(VkCommandBuffer buffer);
+
+    void begin(VkCommandBuffer buffer); // Start tracking a freshly begun command buffer, stats are cleared
+    void invalidate(); // Forget the bound state, the next calls are all emitted
+
+    void bind_pipeline(RID pipeline, VkPipelineBindPoint bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS);
+    void bind_descriptor_set(RID pipeline_layout, RID descriptor_set, VkPipelineBindPoint bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS,
+        uint32_t first_set = 0, const uint32_t *offsets = nullptr, uint32_t offset_count = 0);
+    void bind_vertex_buffers(uint32_t first_binding, uint32_t count, const VkBuffer *buffers, const VkDeviceSize *offsets);
+    void bind_index_buffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType type);
+    void bind_mesh(const Mesh &mesh); // Index buffer and one vertex binding per attribute stream
+
+    void viewport(VkExtent2D extent);
+    void viewport(const VkViewport &viewport);
+    void scissor(VkRect2D rect);
+
+    void draw(uint32_t vertex_count, uint32_t instance_count = 1, uint32_t first_vertex = 0, uint32_t first_instance = 0);
+    void draw_indexed(uint32_t index_count, uint32_t instance_count = 1, uint32_t first_index = 0, int32_t vertex_offset = 0, uint32_t first_instance = 0);
+    void dispatch(uint32_t group_count_x, uint32_t group_count_y = 1, uint32_t group_count_z = 1);
+
+    BindPointState &state(VkPipelineBindPoint bind_point);
+
+    operator VkCommandBuffer() const { return buffer; }
+};
+
+#endif // ALCHEMIST_VULKAN_RECORDER_HPP
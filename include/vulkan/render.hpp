@@ -9,6 +9,8 @@
 void bind_pipeline(VkCommandBuffer cmd_buffer, RID pipeline, VkPipelineBindPoint bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS);
 void viewport(VkCommandBuffer cmd_buffer, VkExtent2D extent);
 void scissor(VkCommandBuffer cmd_buffer, VkRect2D rect);
+void dispatch(VkCommandBuffer cmd_buffer, uint32_t group_count_x, uint32_t group_count_y = 1, uint32_t group_count_z = 1);
+void dispatch_indirect(VkCommandBuffer cmd_buffer, RID buffer, VkDeviceSize offset = 0); // Group counts read from a VkDispatchIndirectCommand in the buffer
 void bind_descriptor_sets(VkCommandBuffer cmd_buffer, RID pipeline_layout, RID descriptor_set, VkPipelineBindPoint bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS, uint32_t *offset = nullptr);
 
 #endif // ALCHEMIST_VULKAN_RENDER_HPP
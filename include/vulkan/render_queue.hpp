@@ -0,0 +1,65 @@
+
+#ifndef ALCHEMIST_VULKAN_RENDER_QUEUE_HPP
+#define ALCHEMIST_VULKAN_RENDER_QUEUE_HPP
+
+#include <array>
+#include <utility>
+#include <vector>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "server/rid.hpp"
+#include "vulkan/recorder.hpp"
+
+enum RenderLayer : uint8_t {
+    RENDER_LAYER_OPAQUE = 0, // Sorted by state, then front to back
+    RENDER_LAYER_TRANSPARENT = 1, // Sorted back to front, then by state
+};
+
+struct DrawPacket {
+    RID pipeline = RID_INVALID;
+    RID layout = RID_INVALID; // Pipeline layout the descriptor set is bound with
+    RID descriptor_set = RID_INVALID; // Bound at set 0, RID_INVALID to keep the current one
+    std::array<uint32_t, CommandRecorder::MAX_DYNAMIC_OFFSETS> offsets = {}; // Dynamic offsets of the set
+    uint32_t offset_count = 0;
+
+    RID mesh = RID_INVALID;
+    bool indexed = false; // vkCmdDrawIndexed over the mesh indices, vkCmdDraw otherwise
+    uint32_t first = 0; // First vertex or index, relative to the mesh
+    uint32_t count = 0; // Vertex or index count
+    int32_t vertex_offset = 0; // Added to the indices of indexed draws, on top of the mesh offset
+    uint32_t instance_count = 1;
+
+    float depth = 0.0f; // Distance to the camera, negative values are clamped to 0
+};
+
+// Draws pushed by a scene during a frame, radix sorted on a 64 bit key and recorded with the fewest state changes
+// Key layout: | pass (4 bits) | layer (2 bits) | opaque: pipeline (16) set (14) mesh (12) depth (16) |
+//                                              | transparent: ~depth (32) pipeline (16) set (10)    |
+struct RenderQueue {
+    static constexpr uint32_t MAX_PASSES = 16;
+
+    struct SortEntry {
+        uint64_t key;
+        uint32_t packet; // Index in packets
+    };
+
+    std::vector<DrawPacket> packets;
+    std::vector<SortEntry> entries; // Sorted by sort()
+    std::vector<SortEntry> scratch; // Ping-pong buffer of the radix sort
+
+    void clear(); // Keeps the capacity, a steady frame allocates nothing
+
+    void push(const DrawPacket &packet, uint8_t pass = 0, RenderLayer layer = RENDER_LAYER_OPAQUE);
+    void sort();
+
+    void record(CommandRecorder &recorder, uint8_t pass) const; // Record the sorted draws of a pass, inside its render pass
+    void record(CommandRecorder &recorder, uint32_t first, uint32_t last) const; // Record the sorted draws in [first, last)
+
+    std::pair<uint32_t, uint32_t> pass_range(uint8_t pass) const; // Sorted draws of a pass, as [first, last)
+
+    static uint64_t make_key(const DrawPacket &packet, uint8_t pass, RenderLayer layer);
+};
+
+#endif // ALCHEMIST_VULKAN_RENDER_QUEUE_HPP
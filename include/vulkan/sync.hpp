@@ -43,6 +43,17 @@ struct Fence {
     uint32_t is_signaled() const;
 };
 
+// Completion of one submission, the queue timeline semaphore reaching value
+struct GpuFuture {
+    VkDevice device = VK_NULL_HANDLE; // Vulkan device associated with the semaphore
+    VkSemaphore semaphore = VK_NULL_HANDLE; // Timeline semaphore of the queue, not owned
+    uint64_t value = 0; // Counter value signaled by the submission
+
+    bool valid() const;
+    bool is_ready() const;
+    bool wait(uint64_t timeout = UINT64_MAX) const; // False on timeout or error
+};
+
 struct SemaphoreBuilder {
     VkSemaphoreCreateInfo create_info;
     VkDevice device;
@@ -50,6 +50,8 @@
 #include "server/pipeline.hpp"
 #include "server/shader.hpp"
 #include "server/framebuffer.hpp"
+#include "server/transfer.hpp"
+#include "server/deletion.hpp"
 
 #include "vulkan/command_buffer.hpp"
 
@@ -88,11 +90,11 @@ void framebuffer_resize_callback(GLFWwindow *window, int width, int height) {
     Global &global = Global::instance();
     global.need_resize = true;
 
-    // Resize the swapchain or handle the resize event as needed
-    // This is where you would typically recreate the swapchain with the new
-    // dimensions For now, we just print the new dimensions
+    // The swapchain is recreated at the start of the next frame
+    #ifdef ALCHEMIST_DEBUG
     std::cout << "Framebuffer resized to: " << width << "x" << height
               << std::endl;
+    #endif
 }
 
 void mouse_button_callback(GLFWwindow *window, int button, int action,
@@ -141,7 +143,7 @@ int main() {
     glfwInit();
 
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
     GLFWwindow *window = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan", nullptr, nullptr);
 
@@ -156,7 +158,10 @@ int main() {
         "Alchemist",
         VK_MAKE_API_VERSION(0, 1, 0, 0),
         VK_MAKE_API_VERSION(0, 1, 0, 0),
-        QueueFamilyPreferences::QUEUE_FAMILY_PREFERENCES_SEPARATE
+        QueueFamilyPreferences::QUEUE_FAMILY_PREFERENCES_SEPARATE,
+        2, // Frames in flight
+        3, // Swapchain images
+        true // Async compute
     };
 
     #ifdef ALCHEMIST_DEBUG
@@ -586,7 +591,10 @@ int main() {
     //                  image_index);
     //     renderer.current_frame = (renderer.current_frame + 1) % 2;
 
-    QueueServer::instance().get_queue(global.present_queue).wait();
+    vkDeviceWaitIdle(global.rendering_device.device); // Every queue, the transfer and compute ones included
+    global.collect_swapchain_garbage(true);
+    DeletionQueue::__instance.reset(); // Destroys what was still waiting, the device is idle
+    TransferServer::__instance.reset();
     FramebufferServer::__instance.reset();
     PipelineServer::__instance.reset();
     PipelineLayoutServer::__instance.reset();
@@ -603,7 +611,6 @@ int main() {
     RenderPassServer::__instance.reset();
     BufferServer::__instance.reset();
     GpuMemoryServer::__instance.reset();
-    RIDServer::__instance.reset();
     EditorServer::__instance.reset();
 
     Global::__instance.reset();
@@ -0,0 +1,65 @@
+
+# Pack every compiled .spv of a directory into one archive read by ShaderServer::open_archive
+#
+# Layout, little endian:
+#   header  : magic "ALSP", version, entry count, reserved          (4 x u32)
+#   index   : entry count x (name hash u64, offset u64, size u64), sorted by hash
+#   data    : SPIR-V blobs, each starting on a DATA_ALIGNMENT boundary
+import os
+import struct
+import sys
+
+MAGIC = b'ALSP'
+VERSION = 1
+DATA_ALIGNMENT = 16
+HEADER = struct.Struct('<4sIII')
+ENTRY = struct.Struct('<QQQ')
+
+def fnv1a_64(name):
+    # Must match shader_name_hash in src/server/shader.cpp
+    h = 0xcbf29ce484222325
+    for byte in name.encode('utf-8'):
+        h ^= byte
+        h = (h * 0x100000001b3) & 0xffffffffffffffff
+    return h
+
+def align(value, alignment):
+    return (value + alignment - 1) & ~(alignment - 1)
+
+def pack_shaders(shader_dir, output):
+    names = sorted(f for f in os.listdir(shader_dir) if f.endswith('.spv'))
+
+    entries = []
+    for name in names:
+        with open(os.path.join(shader_dir, name), 'rb') as f:
+            entries.append((fnv1a_64(name), name, f.read()))
+    entries.sort(key=lambda entry: entry[0])
+
+    hashes = [entry[0] for entry in entries]
+    if len(set(hashes)) != len(hashes):
+        raise RuntimeError('Shader name hash collision, rename one of the shaders')
+
+    offset = align(HEADER.size + ENTRY.size * len(entries), DATA_ALIGNMENT)
+    index = bytearray()
+    data = bytearray()
+    for name_hash, name, code in entries:
+        if len(code) % 4 != 0:
+            raise RuntimeError(f'{name} is not a SPIR-V module')
+        index += ENTRY.pack(name_hash, offset + len(data), len(code))
+        data += code
+        data += bytes(align(len(data), DATA_ALIGNMENT) - len(data))
+
+    header = HEADER.pack(MAGIC, VERSION, len(entries), 0)
+    padding = bytes(offset - HEADER.size - len(index))
+
+    tmp = output + '.tmp'
+    with open(tmp, 'wb') as f:
+        f.write(header + index + padding + data)
+    os.replace(tmp, output)
+
+    print(f"Packed {len(entries)} shaders into {output}")
+
+if __name__ == "__main__":
+    shader_directory = sys.argv[1] if len(sys.argv) > 1 else 'assets/shaders/'
+    archive = sys.argv[2] if len(sys.argv) > 2 else 'shaders.pak' # The build packs into its own tree, never next to the sources
+    pack_shaders(shader_directory, archive)
@@ -7,6 +7,8 @@
 #include "imgui_impl_vulkan.h"
 #endif
 
+#include <algorithm>
+
 #include "editor/global.hpp"
 #include "editor/server.hpp"
 
@@ -22,6 +24,8 @@
 #include "server/pipeline.hpp"
 #include "server/shader.hpp"
 #include "server/framebuffer.hpp"
+#include "server/transfer.hpp"
+#include "server/deletion.hpp"
 
 #include "vulkan/command_buffer.hpp" // Include the RID type definition
 #include "vulkan/sync.hpp" // Include the RID type definition
@@ -32,6 +36,10 @@
 #define ALCHEMIST_ROOT "" // Define the root path if not defined
 #endif
 
+#ifndef ALCHEMIST_BUILD_ROOT
+#define ALCHEMIST_BUILD_ROOT "" // Generated files, like the shader archive
+#endif
+
 static void check_imgui_vulkan(VkResult result) {
     if (result != VK_SUCCESS) {
         #ifdef ALCHEMIST_DEBUG
@@ -43,11 +51,11 @@ static void check_imgui_vulkan(VkResult result) {
 
 void Global::init(const ApplicationInfo &info) {
     window = info.window; // Set the GLFW window pointer
+    frames_in_flight = std::clamp(info.frames_in_flight, 1u, MAX_FRAMES_IN_FLIGHT);
     rendering_device = std::move(RenderingDevice(info)); // Initialize the rendering device with the provided application info
 
     EditorServer &editor_server = EditorServer::instance();
 
-    editor_server.emplace_server<RIDServer>();
     editor_server.emplace_server<GpuMemoryServer>(rendering_device.device, rendering_device.physical_device);
     editor_server.emplace_server<RenderPassServer>(rendering_device.device);
     editor_server.emplace_server<ImageServer>(rendering_device.device, rendering_device.physical_device);
@@ -60,73 +68,38 @@ void Global::init(const ApplicationInfo &info) {
     editor_server.emplace_server<DescriptorServer>(rendering_device.device);
     editor_server.emplace_server<DescriptorLayoutServer>(rendering_device.device);
     editor_server.emplace_server<DescriptorPoolServer>(rendering_device.device);
-    editor_server.emplace_server<PipelineServer>(rendering_device.device);
+    editor_server.emplace_server<PipelineServer>(rendering_device.device, rendering_device.physical_device, ALCHEMIST_ROOT "/pipeline.cache");
     editor_server.emplace_server<ShaderServer>(rendering_device.device);
     editor_server.emplace_server<PipelineLayoutServer>(rendering_device.device);
     editor_server.emplace_server<FramebufferServer>(rendering_device.device);
+    editor_server.emplace_server<DeletionQueue>(frames_in_flight);
 
-    command_buffers.reserve(2);
-    gui_command_buffers.reserve(rendering_device.swapchain_image_count);
-    fences.reserve(2);
-    image_semaphores.reserve(2);
-    render_semaphores.reserve(2);
+    fences.reserve(frames_in_flight);
+    image_semaphores.reserve(frames_in_flight);
+    render_semaphores.reserve(rendering_device.swapchain_image_count);
     
-    framebuffer.resize(rendering_device.swapchain_image_count);
-    gui_framebuffer.resize(rendering_device.swapchain_image_count);
-
     graphic_queue = QueueServer::instance().new_queue(
         rendering_device.graphics_queue_family_index, 0
     );
     present_queue = QueueServer::instance().new_queue(
         rendering_device.present_queue_family_index, 0
     );
-
-    depth_image = ImageServer::instance().new_image()
-        .set_format(rendering_device.depth_format)
-        .set_size(rendering_device.swapchain_extent.width,
-                    rendering_device.swapchain_extent.height, 1)
-        .set_usage(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
-        // .set_aspect(VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT)
-        .set_samples(VK_SAMPLE_COUNT_1_BIT)
-        .build();
-    
-    VkMemoryRequirements depth_requirements;
-    
-    ImageServer::instance().get_requirements(depth_image, depth_requirements);
-    depth_memory = GpuMemoryServer::instance().allocate_block<VkImage>(
-        depth_requirements.size,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        find_memory_type(rendering_device.physical_device,
-                         depth_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+    transfer_queue = QueueServer::instance().new_queue(
+        rendering_device.transfer_queue_family_index, 0
     );
 
-    ImageServer::instance().bind_image(depth_image, depth_memory);
+    uint32_t compute_family = rendering_device.graphics_queue_family_index;
+    if (info.async_compute && rendering_device.compute_queue_family_index != rendering_device.graphics_queue_family_index) {
+        compute_family = rendering_device.compute_queue_family_index;
+        compute_queue = QueueServer::instance().new_queue(compute_family, 0);
+    } else {
+        compute_queue = graphic_queue; // Compute is recorded and submitted with graphics
+    }
 
-    depth_view = ImageViewServer::instance().new_image_view()
-        .set_image(depth_image)
-        .set_view_type(VK_IMAGE_VIEW_TYPE_2D)
-        .set_format(rendering_device.depth_format)
-        .set_aspect_mask(VK_IMAGE_ASPECT_DEPTH_BIT)
-        .build();
-    
     desc_pool = DescriptorPoolServer::instance().new_descriptor_pool()
         .add_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 10)
         .add_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 10)
         .build();
-    auto builder = DescriptorLayoutServer::instance().new_descriptor_layout();
-    builder.add_binding()
-        .set_binding(0)
-        .set_stage_flags(VK_SHADER_STAGE_VERTEX_BIT)
-        .set_descriptor_type(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
-        .set_descriptor_count(1);
-    builder.add_binding()
-        .set_binding(1)
-        .set_stage_flags(VK_SHADER_STAGE_VERTEX_BIT)
-        .set_descriptor_type(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
-        .set_descriptor_count(1);
-    desc_layout = builder.build();
-    desc = DescriptorServer::instance().new_descriptor(desc_pool, desc_layout);
-
     gui_desc_pool = DescriptorPoolServer::instance().new_descriptor_pool()
         .add_pool_size(VK_DESCRIPTOR_TYPE_SAMPLER, 1000)
         .add_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000)
@@ -141,12 +114,29 @@ void Global::init(const ApplicationInfo &info) {
         .add_pool_size(VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1000)
         .build();
     
-    vert = ShaderServer::instance().from_file(ALCHEMIST_ROOT "/assets/shaders/line.vert.spv");
-    frag = ShaderServer::instance().from_file(ALCHEMIST_ROOT "/assets/shaders/line.frag.spv");
-    cube_vert = ShaderServer::instance().from_file(ALCHEMIST_ROOT "/assets/shaders/cube.vert.spv");
-    cube_frag = ShaderServer::instance().from_file(ALCHEMIST_ROOT "/assets/shaders/cube.frag.spv");
+    ShaderServer::instance().open_archive(ALCHEMIST_BUILD_ROOT "/shaders.pak", ALCHEMIST_ROOT "/assets/shaders/"); // Packed at build time, missing shaders fall back to the loose files
+
+    vert = ShaderServer::instance().from_archive("line.vert.spv");
+    frag = ShaderServer::instance().from_archive("line.frag.spv");
+    cube_vert = ShaderServer::instance().from_archive("cube.vert.spv");
+    cube_frag = ShaderServer::instance().from_archive("cube.frag.spv");
+
+    // Both vertex shaders share their interface, so they resolve to the same layouts and the set stays bound across pipelines
+    ShaderLayout gizmo_layout = ShaderServer::instance().new_layout()
+        .add_shader(vert)
+        .add_shader(frag)
+        .set_dynamic(0, 1) // Per-object data, indexed with a dynamic offset
+        .build();
+    ShaderLayout cube_layout = ShaderServer::instance().new_layout()
+        .add_shader(cube_vert)
+        .add_shader(cube_frag)
+        .set_dynamic(0, 1)
+        .build();
 
-    gizmo_pipeline_lyt = PipelineLayoutServer::instance().new_pipeline_layout().add_layout(desc_layout).build();
+    desc_layout = gizmo_layout.set_layouts[0];
+    desc = DescriptorServer::instance().new_descriptor(desc_pool, desc_layout);
+    gizmo_pipeline_lyt = gizmo_layout.pipeline_layout;
+    cube_pipeline_lyt = cube_layout.pipeline_layout;
 
     render_pass = default_render_pass(rendering_device.surface_format.format, rendering_device.depth_format);
 
@@ -159,10 +149,7 @@ void Global::init(const ApplicationInfo &info) {
     pipeline_builder.add_shader(vert, VK_SHADER_STAGE_VERTEX_BIT);
     pipeline_builder.add_shader(frag, VK_SHADER_STAGE_FRAGMENT_BIT);
     pipeline_builder.set_vertex_input()
-        .add_binding<vec3>(0)
-        .add_binding<vec3>(1)
-        .add_attribute<vec3>(0, 0, 0)
-        .add_attribute<vec3>(1, 1, 0)
+        .add_vertex<QuantizedVertex<PositionColorVertex>>(0) // Interleaved, the gizmo mesh is built quantized from the same struct
         .build();
     pipeline_builder.set_input_assembly(VK_PRIMITIVE_TOPOLOGY_LINE_LIST)
         .set_depth_stencil()
@@ -171,7 +158,7 @@ void Global::init(const ApplicationInfo &info) {
             .set_depth_compare_op(VK_COMPARE_OP_LESS)
             .set_depth_bounds_test_enable(VK_FALSE)
             .set_stencil_test_enable(VK_FALSE);
-    gizmo_pipeline = pipeline_builder.set_layout(gizmo_pipeline_lyt).set_render_pass(render_pass).build();
+    gizmo_pipeline = pipeline_builder.set_layout(gizmo_pipeline_lyt).set_render_pass(render_pass).build_async();
     }
 
     {
@@ -179,67 +166,63 @@ void Global::init(const ApplicationInfo &info) {
     pipeline_builder.add_shader(cube_vert, VK_SHADER_STAGE_VERTEX_BIT);
     pipeline_builder.add_shader(cube_frag, VK_SHADER_STAGE_FRAGMENT_BIT);
     pipeline_builder.set_vertex_input()
-        .add_binding<vec3>(0)
-        .add_binding<vec3>(1)
-        .add_attribute<vec3>(0, 0, 0)
-        .add_attribute<vec3>(1, 1, 0)
+        .add_vertex<PositionNormalVertex>(0)
         .build();
     pipeline_builder.cull_mode(VK_CULL_MODE_NONE);
-    pipeline_builder.set_input_assembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP)
+    pipeline_builder.set_input_assembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
         .set_depth_stencil()
             .set_depth_test_enable(VK_TRUE)
             .set_depth_write_enable(VK_TRUE)
             .set_depth_compare_op(VK_COMPARE_OP_LESS)
             .set_depth_bounds_test_enable(VK_FALSE)
             .set_stencil_test_enable(VK_FALSE);
-    cube_pipeline = pipeline_builder.set_layout(gizmo_pipeline_lyt).set_render_pass(render_pass).build();
+    cube_pipeline = pipeline_builder.set_layout(cube_pipeline_lyt).set_render_pass(render_pass).build_async();
     }
 
-    for (uint32_t i = 0; i < rendering_device.swapchain_image_count; ++i) {
-        framebuffer[i] = FramebufferServer::instance().new_framebuffer(
-                rendering_device.swapchain_extent.width,
-                rendering_device.swapchain_extent.height,
-                1
-            )
-            .set_render_pass(render_pass)
-            .add_attachment(rendering_device.swapchain_image_views[i])
-            .add_attachment(depth_view)
-            .build();
-    }
+    create_swapchain_resources(); // Overlaps with the pipeline compilation
 
-    for (uint32_t i = 0; i < rendering_device.swapchain_image_count; ++i) {
-        gui_framebuffer[i] = FramebufferServer::instance().new_framebuffer(
-                rendering_device.swapchain_extent.width,
-                rendering_device.swapchain_extent.height,
-                1
-            )
-            .set_render_pass(gui_render_pass)
-            .add_attachment(rendering_device.swapchain_image_views[i])
-            .build();
+    frame_command_pools.reserve(frames_in_flight);
+    for (uint32_t i = 0; i < frames_in_flight; ++i) {
+        frame_command_pools.push_back(CommandPoolServer::instance().new_command_pool()
+            .set_flags(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT) // Reset in bulk once the frame fence signals
+            .set_queue_family_index(rendering_device.graphics_queue_family_index)
+            .build());
     }
 
-    command_pool = CommandPoolServer::instance().new_command_pool()
-        .set_flags(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT)
-        .set_queue_family_index(rendering_device.graphics_queue_family_index)
+    transfer_command_pool = CommandPoolServer::instance().new_command_pool()
+        .set_flags(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT)
+        .set_queue_family_index(rendering_device.transfer_queue_family_index)
         .build();
-    
-    gui_command_pool = CommandPoolServer::instance().new_command_pool()
+
+    compute_command_pool = CommandPoolServer::instance().new_command_pool()
         .set_flags(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT)
-        .set_queue_family_index(rendering_device.graphics_queue_family_index)
+        .set_queue_family_index(compute_family)
         .build();
+
+    editor_server.emplace_server<TransferServer>(
+        rendering_device.device,
+        transfer_queue,
+        transfer_command_pool,
+        rendering_device.transfer_queue_family_index,
+        rendering_device.graphics_queue_family_index
+    );
     
-    emplace_command_buffer(command_buffers, 2, command_pool); // Allocate command buffers
-    emplace_command_buffer(gui_command_buffers, rendering_device.swapchain_image_count, gui_command_pool); // Allocate command buffers
+    command_buffers.resize(frames_in_flight); // Acquired from the frame pools by begin_frame_commands
+    gui_command_buffers.resize(frames_in_flight);
+    parallel_recorder = std::make_unique<ParallelRecorder>(frames_in_flight, rendering_device.graphics_queue_family_index);
     SemaphoreBuilder(rendering_device.device)
-        .emplace(image_semaphores, 2); // Create image semaphores
+        .emplace(image_semaphores, frames_in_flight); // Create image semaphores
     SemaphoreBuilder(rendering_device.device)
-        .emplace(render_semaphores, 2); // Create render semaphores
+        .emplace(render_semaphores, rendering_device.swapchain_image_count); // One per image, the presentation engine holds it until the image comes back
     FenceBuilder(rendering_device.device)
         .signaled()
-        .emplace(fences, 2); // Create fences
+        .emplace(fences, frames_in_flight); // Create fences
+
+    PipelineServer::instance().wait_all(); // Every pipeline is compiled before the first frame
 
     #ifdef ALCHEMIST_DEBUG
     std::cout << "Global initialized with window: " << window << std::endl;
+    std::cout << "Frames in flight: " << frames_in_flight << ", swapchain images: " << rendering_device.swapchain_image_count << std::endl;
 
     ImGui::CreateContext();
     ImGui::StyleColorsDark();
@@ -256,7 +239,7 @@ void Global::init(const ApplicationInfo &info) {
     init_info.Device = rendering_device.device;
     init_info.QueueFamily = rendering_device.graphics_queue_family_index;
     init_info.Queue = graphics_queue.queue;
-    init_info.PipelineCache = VK_NULL_HANDLE;
+    init_info.PipelineCache = PipelineServer::instance().cache; // ImGui pipelines are cached too
     init_info.DescriptorPool = imgui_descriptor_pool.pool;
     init_info.Allocator = nullptr;
     init_info.MinImageCount = rendering_device.swapchain_image_count;
@@ -269,7 +252,134 @@ void Global::init(const ApplicationInfo &info) {
     #endif
 }
 
+void Global::create_swapchain_resources() {
+    framebuffer.resize(rendering_device.swapchain_image_count);
+    gui_framebuffer.resize(rendering_device.swapchain_image_count);
+
+    depth_image = ImageServer::instance().new_image()
+        .set_format(rendering_device.depth_format)
+        .set_size(rendering_device.swapchain_extent.width,
+                    rendering_device.swapchain_extent.height, 1)
+        .set_usage(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
+        // .set_aspect(VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT)
+        .set_samples(VK_SAMPLE_COUNT_1_BIT)
+        .build();
+    
+    VkMemoryRequirements depth_requirements;
+    
+    ImageServer::instance().get_requirements(depth_image, depth_requirements);
+    depth_memory = GpuMemoryServer::instance().allocate_block<VkImage>(
+        depth_requirements.size,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        find_memory_type(rendering_device.physical_device,
+                         depth_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+    );
+
+    ImageServer::instance().bind_image(depth_image, depth_memory);
+
+    depth_view = ImageViewServer::instance().new_image_view()
+        .set_image(depth_image)
+        .set_view_type(VK_IMAGE_VIEW_TYPE_2D)
+        .set_format(rendering_device.depth_format)
+        .set_aspect_mask(VK_IMAGE_ASPECT_DEPTH_BIT)
+        .build();
+    
+    for (uint32_t i = 0; i < rendering_device.swapchain_image_count; ++i) {
+        framebuffer[i] = FramebufferServer::instance().new_framebuffer(
+                rendering_device.swapchain_extent.width,
+                rendering_device.swapchain_extent.height,
+                1
+            )
+            .set_render_pass(render_pass)
+            .add_attachment(rendering_device.swapchain_image_views[i])
+            .add_attachment(depth_view)
+            .build();
+    }
+
+    for (uint32_t i = 0; i < rendering_device.swapchain_image_count; ++i) {
+        gui_framebuffer[i] = FramebufferServer::instance().new_framebuffer(
+                rendering_device.swapchain_extent.width,
+                rendering_device.swapchain_extent.height,
+                1
+            )
+            .set_render_pass(gui_render_pass)
+            .add_attachment(rendering_device.swapchain_image_views[i])
+            .build();
+    }
+}
+
+bool Global::recreate_swapchain() {
+    SwapchainGarbage garbage;
+    bool created = rendering_device.recreate_swapchain(window, garbage.swapchain);
+    if (!created && garbage.swapchain.swapchain == VK_NULL_HANDLE) {
+        return false; // Minimized, try again next frame
+    }
+
+    garbage.framebuffers = std::move(framebuffer);
+    garbage.framebuffers.insert(garbage.framebuffers.end(), gui_framebuffer.begin(), gui_framebuffer.end());
+    garbage.retire_frame = frame_count;
+    framebuffer.clear();
+    gui_framebuffer.clear();
+
+    if (!created) {
+        swapchain_garbage.push_back(std::move(garbage)); // The failed creation retired the old swapchain, the depth buffer is kept
+        return false; // Try again from scratch next frame
+    }
+
+    garbage.depth_image = depth_image;
+    garbage.depth_memory = depth_memory;
+    garbage.depth_view = depth_view;
+    swapchain_garbage.push_back(std::move(garbage)); // Frames already submitted may still use it
+
+    create_swapchain_resources();
+
+    if (render_semaphores.size() < rendering_device.swapchain_image_count) {
+        SemaphoreBuilder(rendering_device.device)
+            .emplace(render_semaphores, rendering_device.swapchain_image_count - render_semaphores.size()); // More images than before
+    }
+
+    #ifdef ALCHEMIST_DEBUG
+    ImGui_ImplVulkan_SetMinImageCount(rendering_device.swapchain_image_count);
+    std::cout << "Swapchain recreated: " << rendering_device.swapchain_extent.width << "x" << rendering_device.swapchain_extent.height << std::endl;
+    #endif
+
+    need_resize = false;
+    return true;
+}
+
+void Global::collect_swapchain_garbage(bool force) {
+    while (!swapchain_garbage.empty()) {
+        SwapchainGarbage &garbage = swapchain_garbage.front();
+        // Frame f waits on the fence of frame f - frames_in_flight, every frame before retire_frame is done once that reaches retire_frame - 1
+        if (!force && frame_count + 1 < garbage.retire_frame + frames_in_flight) {
+            break;
+        }
+
+        for (RID fb : garbage.framebuffers) {
+            FramebufferServer::instance().free_framebuffer(fb);
+        }
+        if (garbage.depth_image != RID_INVALID) { // Kept when only the swapchain was lost
+            ImageViewServer::instance().free_image_view(garbage.depth_view);
+            ImageServer::instance().free_image(garbage.depth_image);
+            GpuMemoryServer::instance().free_block(garbage.depth_memory);
+        }
+        rendering_device.destroy_swapchain(garbage.swapchain);
+
+        swapchain_garbage.pop_front();
+    }
+}
+
+void Global::begin_frame_commands() {
+    CommandPoolServer &pool_server = CommandPoolServer::instance();
+    RID pool = frame_command_pools[flight_frame];
+
+    pool_server.reset_command_pool(pool); // One reset for every buffer the frame recorded
+    command_buffers[flight_frame] = pool_server.acquire_command_buffer(pool); // Recycled, nothing is allocated after the first frames
+    gui_command_buffers[flight_frame] = pool_server.acquire_command_buffer(pool);
+}
+
 Global::~Global() {
+    parallel_recorder.reset(); // Join the recording threads
     command_buffers.clear();
     fences.clear();
     image_semaphores.clear();
@@ -93,11 +93,13 @@ static void find_queue_families(VkPhysicalDevice device, VkSurfaceKHR surface, I
                 indices.present = i;
             }
         }
-        if (queue_families[i].queueFlags & VK_QUEUE_COMPUTE_BIT) {
-            indices.compute = i;
+        if ((queue_families[i].queueFlags & VK_QUEUE_COMPUTE_BIT) &&
+            (indices.compute == UINT32_MAX || !(queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT))) {
+            indices.compute = i; // Prefer an async compute family, it runs beside graphics
         }
-        if (queue_families[i].queueFlags & VK_QUEUE_TRANSFER_BIT) {
-            indices.transfer = i;
+        if ((queue_families[i].queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+            (indices.transfer == UINT32_MAX || !(queue_families[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))) {
+            indices.transfer = i; // Prefer a dedicated transfer family, its DMA engine runs beside graphics
         }
     }
 
@@ -269,7 +271,12 @@ void create_device(RenderingDevice &device) {
         count++;
     }
 
+    VkPhysicalDeviceVulkan12Features features12{};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features12.timelineSemaphore = VK_TRUE; // Queue timelines back the submit futures
+
     device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    device_create_info.pNext = &features12;
     device_create_info.queueCreateInfoCount = count; // Number of queue create infos
     device_create_info.pQueueCreateInfos = queue_create_info; // Set the queue create infos
     device_create_info.pEnabledFeatures =
@@ -336,7 +343,7 @@ int query_swapchain_support(VkPhysicalDevice device, VkSurfaceKHR surface) {
     return 0; // Success
 }
 
-void create_swapchain(RenderingDevice &device, GLFWwindow *window) {
+bool create_swapchain(RenderingDevice &device, GLFWwindow *window, VkSwapchainKHR old_swapchain) {
     VkSwapchainCreateInfoKHR swapchain_create_info{};
 
     VkSurfaceCapabilitiesKHR capabilities;
@@ -394,14 +401,14 @@ void create_swapchain(RenderingDevice &device, GLFWwindow *window) {
     delete[] present_modes;
 
     glfwGetFramebufferSize(window, &width, &height);
-    device.swapchain_extent.width = static_cast<uint32_t>(width);
-    device.swapchain_extent.height = static_cast<uint32_t>(height);
-    if (device.swapchain_extent.width == 0 || device.swapchain_extent.height == 0) {
+    if (width <= 0 || height <= 0) {
 #ifdef ALCHEMIST_DEBUG
         std::cerr << "Invalid swapchain extent." << std::endl;
 #endif
-        return; // Invalid swapchain extent
+        return false; // Invalid swapchain extent, the window is minimized
     }
+    device.swapchain_extent.width = static_cast<uint32_t>(width);
+    device.swapchain_extent.height = static_cast<uint32_t>(height);
 
     device.swapchain_extent.width =
         std::clamp(device.swapchain_extent.width,
@@ -412,8 +419,11 @@ void create_swapchain(RenderingDevice &device, GLFWwindow *window) {
                    capabilities.minImageExtent.height,
                    capabilities.maxImageExtent.height);
 
-    device.swapchain_image_count = capabilities.minImageCount + 1;
+    device.swapchain_image_count = device.requested_image_count ? device.requested_image_count : capabilities.minImageCount + 1;
 
+    if (device.swapchain_image_count < capabilities.minImageCount) {
+        device.swapchain_image_count = capabilities.minImageCount;
+    }
     if (capabilities.maxImageCount > 0 &&
         device.swapchain_image_count > capabilities.maxImageCount) {
         device.swapchain_image_count = capabilities.maxImageCount;
@@ -444,17 +454,49 @@ void create_swapchain(RenderingDevice &device, GLFWwindow *window) {
     swapchain_create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     swapchain_create_info.presentMode = device.present_mode;
     swapchain_create_info.clipped = VK_TRUE;
-    swapchain_create_info.oldSwapchain = VK_NULL_HANDLE;
+    swapchain_create_info.oldSwapchain = old_swapchain; // Lets the driver hand the old images over
 
     if (vkCreateSwapchainKHR(device.device, &swapchain_create_info, nullptr,
                              &device.swapchain) != VK_SUCCESS) {
 #ifdef ALCHEMIST_DEBUG
         std::cerr << "Failed to create swapchain." << std::endl;
 #endif
-        return; // Failed to create swapchain
+        return false; // Failed to create swapchain
     }
 
-    return;
+    return true;
+}
+
+void create_swapchain_views(RenderingDevice &device) {
+    vkGetSwapchainImagesKHR(device.device, device.swapchain, &device.swapchain_image_count, nullptr);
+    device.swapchain_images = new VkImage[device.swapchain_image_count];
+    device.swapchain_image_views = new VkImageView[device.swapchain_image_count];
+    if (vkGetSwapchainImagesKHR(device.device, device.swapchain, &device.swapchain_image_count, device.swapchain_images) != VK_SUCCESS) {
+    #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to create Images." << std::endl;
+    #endif
+    }
+
+    for (uint32_t i = 0; i < device.swapchain_image_count; i++) {
+        VkImageViewCreateInfo view_info{};
+
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.image = device.swapchain_images[i];
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_info.format = device.surface_format.format;
+        view_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        view_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        view_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        view_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+        view_info.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+        if (vkCreateImageView(device.device, &view_info, nullptr, &device.swapchain_image_views[i]) !=
+            VK_SUCCESS) {
+        #ifdef ALCHEMIST_DEBUG
+                std::cerr << "Failed to create Image Views." << std::endl;
+        #endif
+        }
+    }
 }
 
 RenderingDevice::RenderingDevice(const ApplicationInfo &info) {
@@ -564,39 +606,12 @@ RenderingDevice::RenderingDevice(const ApplicationInfo &info) {
         return; // Failed to create Vulkan surface
     }
 
+    requested_image_count = info.swapchain_images;
+
     pick_physical_device(*this);
     create_device(*this);
-    create_swapchain(*this, info.window);
-
-    vkGetSwapchainImagesKHR(device, swapchain, &swapchain_image_count, nullptr);
-    swapchain_images = new VkImage[swapchain_image_count];
-    swapchain_image_views = new VkImageView[swapchain_image_count];
-    if (vkGetSwapchainImagesKHR(device, swapchain, &swapchain_image_count, swapchain_images) != VK_SUCCESS) {
-    #ifdef ALCHEMSIT_DEBUG
-        std::cerr << "Failed to create Images." << std::endl;
-    #endif
-    }
-
-    for (uint32_t i = 0; i < swapchain_image_count; i++) {
-        VkImageViewCreateInfo view_info{};
-
-        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        view_info.image = swapchain_images[i];
-        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        view_info.format = surface_format.format;
-        view_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-        view_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-        view_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-        view_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-        view_info.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
-
-        if (vkCreateImageView(device, &view_info, nullptr, &swapchain_image_views[i]) !=
-            VK_SUCCESS) {
-        #ifdef ALCHEMSIT_DEBUG
-                std::cerr << "Failed to create Image Views." << std::endl;
-        #endif
-        }
-    }
+    create_swapchain(*this, info.window, VK_NULL_HANDLE);
+    create_swapchain_views(*this);
 
     for (VkFormat format : {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT}) {
         VkFormatProperties format_props;
@@ -609,6 +624,41 @@ RenderingDevice::RenderingDevice(const ApplicationInfo &info) {
     }
 }
 
+bool RenderingDevice::recreate_swapchain(GLFWwindow *window, RetiredSwapchain &retired) {
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    if (width <= 0 || height <= 0) {
+        retired = {};
+        return false; // Minimized, keep presenting to the old swapchain
+    }
+
+    retired = {swapchain, swapchain_image_count, swapchain_images, swapchain_image_views};
+
+    if (!create_swapchain(*this, window, retired.swapchain)) {
+        // The old swapchain is retired even though the creation failed, it can't be passed as oldSwapchain again
+        if (!create_swapchain(*this, window, VK_NULL_HANDLE)) {
+            swapchain = VK_NULL_HANDLE; // Nothing to present to, retired still has to be destroyed
+            swapchain_image_count = 0;
+            swapchain_images = nullptr;
+            swapchain_image_views = nullptr;
+            return false;
+        }
+    }
+
+    create_swapchain_views(*this);
+    return true;
+}
+
+void RenderingDevice::destroy_swapchain(const RetiredSwapchain &retired) const {
+    for (uint32_t i = 0; i < retired.image_count; i++) {
+        vkDestroyImageView(device, retired.image_views[i], nullptr);
+    }
+    delete[] retired.image_views;
+    delete[] retired.images;
+
+    vkDestroySwapchainKHR(device, retired.swapchain, nullptr); // Images are owned by the swapchain
+}
+
 RenderingDevice::RenderingDevice(RenderingDevice &&other) {
     instance = other.instance;
     #ifdef ALCHEMIST_DEBUG
@@ -627,6 +677,7 @@ RenderingDevice::RenderingDevice(RenderingDevice &&other) {
     present_mode = other.present_mode;
     swapchain_extent = other.swapchain_extent;
     swapchain_image_count = other.swapchain_image_count;
+    requested_image_count = other.requested_image_count;
 
     swapchain_images = other.swapchain_images;
     swapchain_image_views = other.swapchain_image_views;
@@ -673,6 +724,7 @@ RenderingDevice &RenderingDevice::operator=(RenderingDevice &&other) {
         present_mode = other.present_mode;
         swapchain_extent = other.swapchain_extent;
         swapchain_image_count = other.swapchain_image_count;
+        requested_image_count = other.requested_image_count;
 
         swapchain_images = other.swapchain_images;
         swapchain_image_views = other.swapchain_image_views;
@@ -0,0 +1,71 @@
+
+#ifdef ALCHEMIST_DEBUG
+#include <iostream>
+#endif // ALCHEMIST_DEBUG
+
+#include <algorithm>
+
+#include "memory/worker_pool.hpp"
+
+WorkerPool::WorkerPool(uint32_t count) {
+    if (count == 0) {
+        count = std::max(std::thread::hardware_concurrency(), 2u) - 1; // Leave a core to the main thread
+    }
+
+    workers.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        workers.emplace_back(&WorkerPool::run, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkerPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void WorkerPool::wait_idle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return jobs.empty() && active == 0; });
+}
+
+uint32_t WorkerPool::size() const {
+    return static_cast<uint32_t>(workers.size());
+}
+
+void WorkerPool::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (jobs.empty()) {
+            return; // Stopping and nothing left to run
+        }
+
+        std::function<void()> job = std::move(jobs.front());
+        jobs.pop_front();
+        active++;
+
+        lock.unlock();
+        job();
+        lock.lock();
+
+        active--;
+        if (jobs.empty() && active == 0) {
+            idle.notify_all();
+        }
+    }
+}
@@ -3,6 +3,7 @@
 #include <iostream>
 #endif // ALCHEMIST_DEBUG
 
+#include <algorithm>
 #include <cstring>
 
 #include "server/buffer.hpp"
@@ -33,6 +34,17 @@ BufferBuilder &BufferBuilder::set_sharing_mode(VkSharingMode sharing_mode) {
     return *this; // Return the builder for chaining
 }
 
+BufferBuilder &BufferBuilder::set_queue_families(std::initializer_list<uint32_t> families) {
+    queue_families.clear();
+    for (uint32_t family : families) {
+        if (std::find(queue_families.begin(), queue_families.end(), family) == queue_families.end()) {
+            queue_families.push_back(family); // Concurrent families must be unique
+        }
+    }
+    create_info.sharingMode = queue_families.size() > 1 ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+    return *this; // Return the builder for chaining
+}
+
 RID BufferBuilder::build() const {
     if (create_info.size == 0) {
     #ifdef ALCHEMIST_DEBUG
@@ -41,7 +53,13 @@ RID BufferBuilder::build() const {
         return RID_INVALID; // Return an invalid RID if size is not set
     }
 
-    RID rid = server.new_buffer(create_info); // Create the buffer using the server
+    VkBufferCreateInfo info = create_info;
+    if (info.sharingMode == VK_SHARING_MODE_CONCURRENT) {
+        info.queueFamilyIndexCount = static_cast<uint32_t>(queue_families.size());
+        info.pQueueFamilyIndices = queue_families.data();
+    }
+
+    RID rid = server.new_buffer(info); // Create the buffer using the server
     if (rid == RID_INVALID) {
     #ifdef ALCHEMIST_DEBUG
         std::cerr << "Failed to create buffer!" << std::endl;
@@ -53,81 +71,32 @@ RID BufferBuilder::build() const {
 }
 
 
-Buffer::~Buffer() {
-    #ifdef ALCHEMIST_DEBUG
-    std::cout << "Destroying buffer with RID: " << rid << std::endl;
-    #endif
-    if (rid != RID_INVALID) {
-        RIDServer::instance().free(RIDServer::BUFFER, rid); // Free the RID of the buffer
-    }
-    if (memory_rid != RID_INVALID) {
-        RIDServer::instance().free(RIDServer::MEMORY, memory_rid); // Free the memory block associated with the buffer
-    } 
-}
-
-
-
-CmdUploadBuffer::CmdUploadBuffer(CmdUploadBuffer &&other) : buffer(std::move(other.buffer)), staging(std::move(other.staging)), memory_rid(other.memory_rid), copy_region(other.copy_region) {
-    other.staging = VK_NULL_HANDLE; // Reset the staging buffer in the moved-from object
-    other.memory_rid = RID_INVALID; // Reset the memory RID in the moved-from object
-}
+CmdUploadBuffer::CmdUploadBuffer(VkBuffer buffer) : buffer(buffer), staging(VK_NULL_HANDLE) {}
 
-CmdUploadBuffer::CmdUploadBuffer(VkBuffer buffer) : buffer(buffer), staging(VK_NULL_HANDLE), memory_rid(RID_INVALID) {}
-
-CmdUploadBuffer::~CmdUploadBuffer() {
-    if (staging != VK_NULL_HANDLE) {
-        vkDestroyBuffer(BufferServer::instance().device, staging, nullptr); // Clean up the staging buffer
-    }
-    // vkDestroyBuffer(BufferServer::instance().device, staging, nullptr); // Clean up the staging buffer
-    if (memory_rid != RID_INVALID) {
-        GpuMemoryServer::instance().free_block(memory_rid); // Free the memory block associated with the staging buffer
-    }
-}
-
-CmdUploadBuffer &CmdUploadBuffer::upload_data(VkDevice device, VkPhysicalDevice physical_device, VkDeviceSize size, const void *data) {
-    RID rid;
-
-    VkBufferCreateInfo buffer_info = {};
-    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    buffer_info.size = size;
-    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT; // Staging buffer for transfer
-    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-    if (vkCreateBuffer(device, &buffer_info, nullptr, &staging) != VK_SUCCESS) {
+CmdUploadBuffer &CmdUploadBuffer::upload_data(VkDevice device, VkPhysicalDevice physical_device, VkDeviceSize size, const void *data, VkDeviceSize offset) {
+    StagingRegion region = BufferServer::instance().staging.allocate(size); // Sub-allocate from the staging ring
+    if (region.buffer == VK_NULL_HANDLE) {
     #ifdef ALCHEMIST_DEBUG
-        std::cerr << "Failed to create staging buffer!" << std::endl;
+        std::cerr << "Failed to allocate staging memory!" << std::endl;
     #endif
         return *this;
     }
 
-    VkMemoryRequirements mem_requirements;
-    vkGetBufferMemoryRequirements(device, staging, &mem_requirements);
-
-    memory_rid = GpuMemoryServer::instance().allocate_block<VkBuffer>(
-        size,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        find_memory_type(physical_device, mem_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
-    );
-    GpuMemoryServer::instance().bind(memory_rid, mem_requirements, staging);
-    
+    staging = region.buffer;
+
     copy_region = {};
-    copy_region.srcOffset = 0; // No offset for staging buffer
-    copy_region.dstOffset = 0; // No offset for destination buffer
+    copy_region.srcOffset = region.offset; // Offset of the region in the staging ring
+    copy_region.dstOffset = offset; // Where the data lands in the destination buffer
     copy_region.size = size; // Size of the data to copy
 
-    // Copy data to the staging buffer
-    void *mapped_data;
-    GpuMemoryServer::instance().map(memory_rid, &mapped_data);
-    memcpy(mapped_data, data, size);
-    GpuMemoryServer::instance().unmap(memory_rid);
+    memcpy(region.data, data, size); // The ring is persistently mapped and coherent
 
     return *this; // Return the command for chaining
 }
 
 
 
-BufferServer::BufferServer(VkDevice device, VkPhysicalDevice physical_device) : device(device), physical_device(physical_device) {
-    buffers = std::vector<Buffer>();
+BufferServer::BufferServer(VkDevice device, VkPhysicalDevice physical_device) : staging(device, physical_device), device(device), physical_device(physical_device) {
     upload_commands = std::vector<CmdUploadBuffer>();
     command_types = std::vector<BufferCommandType>();
 }
@@ -136,12 +105,11 @@ BufferServer::~BufferServer() {
     for (const auto &buffer : buffers) {
         vkDestroyBuffer(device, buffer.buffer, nullptr); // Clean up each buffer
     }
-    buffers.clear(); // Clear the buffers vector
+    buffers.clear(); // Clear the buffers
 }
 
 RID BufferServer::new_buffer(const VkBufferCreateInfo &create_info) {
     VkBuffer buffer;
-    RID rid = RIDServer::instance().new_id(RIDServer::BUFFER);
 
     if (vkCreateBuffer(device, &create_info, nullptr, &buffer) != VK_SUCCESS) {
     #ifdef ALCHEMIST_DEBUG
@@ -150,14 +118,11 @@ RID BufferServer::new_buffer(const VkBufferCreateInfo &create_info) {
         return RID_INVALID; // Return an invalid RID on failure
     }
 
-    buffers.emplace_back(buffer, rid, 0); // Add the created buffer to the buffers vector
-
-    return rid;
+    return buffers.emplace(buffer, RID_INVALID, RID_INVALID, RID_INVALID, create_info.sharingMode == VK_SHARING_MODE_CONCURRENT); // Add the created buffer to the buffers and return its RID
 }
 
 RID BufferServer::new_buffer(VkBufferCreateInfo &&create_info) {
     VkBuffer buffer;
-    RID rid = RIDServer::instance().new_id(RIDServer::BUFFER);
 
     if (vkCreateBuffer(device, &create_info, nullptr, &buffer) != VK_SUCCESS) {
     #ifdef ALCHEMIST_DEBUG
@@ -166,98 +131,108 @@ RID BufferServer::new_buffer(VkBufferCreateInfo &&create_info) {
         return RID_INVALID; // Return an invalid RID on failure
     }
 
-    buffers.emplace_back(buffer, rid, 0); // Add the created buffer to the buffers vector
-
-    return rid;
+    return buffers.emplace(buffer, RID_INVALID, RID_INVALID, RID_INVALID, create_info.sharingMode == VK_SHARING_MODE_CONCURRENT); // Add the created buffer to the buffers and return its RID
 }
 
 BufferBuilder BufferServer::new_buffer() {
     return BufferBuilder(*this); // Return a BufferBuilder instance for creating buffers
 }
 
+void BufferServer::free_buffer(RID rid) {
+    Buffer *buffer = buffers.get(rid);
+    if (buffer == nullptr) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Buffer with RID " << rid << " not found for release!" << std::endl;
+        #endif
+        return;
+    }
+
+    if (buffer->memory_rid != RID_INVALID && buffer->bind_rid != RID_INVALID) {
+        GpuMemoryServer::instance().unbind(buffer->memory_rid, buffer->bind_rid); // Give the range back to the block
+    }
+    vkDestroyBuffer(device, buffer->buffer, nullptr);
+    buffers.erase(rid);
+}
+
 RID BufferServer::bind_buffer(RID buffer, RID memory) {
     VkMemoryRequirements mem_requirements;
 
-    for (auto &buf : buffers) {
-        if (buf.rid == buffer) {
-            vkGetBufferMemoryRequirements(device, buf.buffer, &mem_requirements);
-            buf.memory_rid = memory; // Set the memory RID for the buffer
-            RID bind_rid = GpuMemoryServer::instance().bind(buf.memory_rid, mem_requirements, buf.buffer); // Bind the buffer to the GPU memory
-
-            if (bind_rid == RID_INVALID) {
-                #ifdef ALCHEMIST_DEBUG
-                std::cerr << "Failed to bind buffer memory for RID: " << buffer << std::endl;
-                #endif
-                return bind_rid; // Return if binding fails
-            }
-            #ifdef ALCHEMIST_DEBUG
-            std::cout << "Buffer with RID " << buffer << " bound to memory with RID " << memory << std::endl;
-            #endif
+    Buffer *buf = buffers.get(buffer);
+    if (buf == nullptr) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Buffer with RID " << buffer << " not found for binding!" << std::endl;
+        #endif
+        return RID_INVALID; // Return an invalid RID if the buffer is not found
+    }
 
-            return bind_rid; // Exit after binding
-        }
+    vkGetBufferMemoryRequirements(device, buf->buffer, &mem_requirements);
+    buf->memory_rid = memory; // Set the memory RID for the buffer
+    RID bind_rid = GpuMemoryServer::instance().bind(buf->memory_rid, mem_requirements, buf->buffer); // Bind the buffer to the GPU memory
+    buf->bind_rid = bind_rid; // Keep the bind so the range can be released later
+
+    if (bind_rid == RID_INVALID) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to bind buffer memory for RID: " << buffer << std::endl;
+        #endif
+        return bind_rid; // Return if binding fails
     }
     #ifdef ALCHEMIST_DEBUG
-    std::cerr << "Buffer with RID " << buffer << " not found for binding!" << std::endl;
+    std::cout << "Buffer with RID " << buffer << " bound to memory with RID " << memory << std::endl;
     #endif
-    return RID_INVALID; // Return an invalid RID if the buffer is not found
+
+    return bind_rid;
 }
 
 void BufferServer::bind_best(RID buffer, VkMemoryPropertyFlags flags) {
     VkMemoryRequirements mem_requirements;
 
-    for (auto &buf : buffers) {
-        if (buf.rid == buffer) {
-            vkGetBufferMemoryRequirements(device, buf.buffer, &mem_requirements);
+    Buffer *buf = buffers.get(buffer);
+    if (buf == nullptr) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Buffer with RID " << buffer << " not found for binding!" << std::endl;
+        #endif
+        return;
+    }
 
-            buf.memory_rid = GpuMemoryServer::instance().find_best<VkBuffer>(mem_requirements, flags);
+    vkGetBufferMemoryRequirements(device, buf->buffer, &mem_requirements);
 
-            if (buf.memory_rid == RID_INVALID) {
-                #ifdef ALCHEMIST_DEBUG
-                std::cerr << "Failed to find suitable memory for buffer with RID: " << buffer << std::endl;
-                #endif
-                return; // Return if no suitable memory is found
-            }
+    buf->memory_rid = GpuMemoryServer::instance().find_best<VkBuffer>(mem_requirements, flags);
 
-            RID bind_rid = GpuMemoryServer::instance().bind(buf.memory_rid, mem_requirements, buf.buffer);
+    if (buf->memory_rid == RID_INVALID) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to find suitable memory for buffer with RID: " << buffer << std::endl;
+        #endif
+        return; // Return if no suitable memory is found
+    }
 
-            if (bind_rid == RID_INVALID) {
-                #ifdef ALCHEMIST_DEBUG
-                std::cerr << "Failed to bind buffer memory for RID: " << buffer << std::endl;
-                #endif
-                return; // Return if binding fails
-            }
-            #ifdef ALCHEMIST_DEBUG
-            std::cout << "Buffer with RID " << buffer << " bound to best memory with RID " << buf.memory_rid << std::endl;
-            #endif
+    RID bind_rid = GpuMemoryServer::instance().bind(buf->memory_rid, mem_requirements, buf->buffer);
+    buf->bind_rid = bind_rid; // Keep the bind so the range can be released later
 
-            return;
-        }
+    if (bind_rid == RID_INVALID) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to bind buffer memory for RID: " << buffer << std::endl;
+        #endif
+        return; // Return if binding fails
     }
-
     #ifdef ALCHEMIST_DEBUG
-    std::cerr << "Buffer with RID " << buffer << " not found for binding!" << std::endl;
+    std::cout << "Buffer with RID " << buffer << " bound to best memory with RID " << buf->memory_rid << std::endl;
     #endif
 }
 
 const Buffer &BufferServer::get_buffer(RID rid) const {
-    for (const auto &buffer : buffers) {
-        if (buffer.rid == rid) {
-            return buffer; // Return the buffer if found
-        }
+    if (const Buffer *buffer = buffers.get(rid)) {
+        return *buffer; // Return the buffer if found
     }
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Buffer with RID " << rid << " not found!" << std::endl;
     #endif
-    return *buffers.cend(); // Return the first buffer as a fallback (should be handled better)
+    return buffers.at(rid); // Invalid buffer as a fallback
 }
 
 void BufferServer::get_requirements(RID rid, VkMemoryRequirements &requirements) const {
-    for (const auto &buffer : buffers) {
-        if (buffer.rid == rid) {
-            vkGetBufferMemoryRequirements(device, buffer.buffer, &requirements);
-            return; // Return the requirements if the buffer is found
-        }
+    if (const Buffer *buffer = buffers.get(rid)) {
+        vkGetBufferMemoryRequirements(device, buffer->buffer, &requirements);
+        return; // Return the requirements if the buffer is found
     }
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Buffer with RID " << rid << " not found for memory requirements!" << std::endl;
@@ -275,6 +250,7 @@ CmdUploadBuffer &BufferServer::upload_buffer(RID rid) {
     }
 
     CmdUploadBuffer cmd(buffer.buffer);
+    cmd.concurrent = buffer.concurrent;
     upload_commands.emplace_back(std::move(cmd));
     command_types.emplace_back(BufferCommandType::UPLOAD);
 
@@ -288,13 +264,15 @@ void BufferServer::execute_commands(VkCommandBuffer cmd_buffer) {
     for (const auto &command : command_types) {
         if (command == BufferCommandType::UPLOAD) {
             const auto &data = upload_commands[upload_index];
-            vkCmdCopyBuffer(
-                cmd_buffer,
-                data.staging,
-                data.buffer,
-                1, // One region
-                &data.copy_region
-            );
+            if (data.staging != VK_NULL_HANDLE) { // Skip uploads that never got staging memory
+                vkCmdCopyBuffer(
+                    cmd_buffer,
+                    data.staging,
+                    data.buffer,
+                    1, // One region
+                    &data.copy_region
+                );
+            }
             upload_index++; // Move to the next upload command
         } else {
             #ifdef ALCHEMIST_DEBUG
@@ -305,14 +283,43 @@ void BufferServer::execute_commands(VkCommandBuffer cmd_buffer) {
     }
 }
 
+void BufferServer::ownership_barriers(uint32_t src_family, uint32_t dst_family, std::vector<VkBufferMemoryBarrier> &release, std::vector<VkBufferMemoryBarrier> &acquire) const {
+    size_t first = acquire.size(); // Only dedupe against the barriers added by this call
+    for (const auto &data : upload_commands) {
+        if (data.staging == VK_NULL_HANDLE || data.concurrent) {
+            continue; // Nothing was copied, or every family can already use the buffer
+        }
+
+        bool known = false;
+        for (size_t i = first; i < acquire.size(); ++i) {
+            known |= acquire[i].buffer == data.buffer;
+        }
+        if (known) {
+            continue; // Several uploads to the same buffer only need one transfer
+        }
+
+        VkBufferMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = src_family;
+        barrier.dstQueueFamilyIndex = dst_family;
+        barrier.buffer = data.buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0; // Ignored on the releasing queue
+        release.push_back(barrier);
+
+        barrier.srcAccessMask = 0; // Ignored on the acquiring queue
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        acquire.push_back(barrier);
+    }
+}
+
 void BufferServer::clear_commands() {
     upload_commands.clear(); // Clear the upload commands
     command_types.clear(); // Clear the command types
 
-    for (auto &buffer : buffers) {
-        buffer.memory_rid = RID_INVALID; // Reset memory RID for each buffer
-    }
-
     #ifdef ALCHEMIST_DEBUG
     std::cout << "Buffer commands cleared." << std::endl;
     #endif
@@ -3,7 +3,10 @@
 #include <iostream> // Include for debug output
 #endif // ALCHEMIST_DEBUG
 
+#include <algorithm>
+
 #include "server/command_pool.hpp"
+#include "vulkan/command_buffer.hpp"
 
 CommandPoolBuilder::CommandPoolBuilder(CommandPoolServer &server) : server(server) {
     create_info = {};
@@ -61,11 +64,9 @@ RID CommandPoolServer::new_command_pool(const VkCommandPoolCreateInfo &create_in
 
     CommandPool pool;
     pool.command_pool = command_pool;
-    pool.rid = RIDServer::instance().new_id(RIDServer::COMMAND_POOL); // Generate a new RID for the command pool
-
-    command_pools.push_back(std::move(pool)); // Add the created command pool to the vector
+    pool.flags = create_info.flags;
 
-    return command_pools.back().rid; // Return the RID of the newly created command pool
+    return command_pools.emplace(std::move(pool)); // Add the created command pool and return its RID
 }
 
 RID CommandPoolServer::new_command_pool(VkCommandPoolCreateInfo &&create_info) {
@@ -79,11 +80,9 @@ RID CommandPoolServer::new_command_pool(VkCommandPoolCreateInfo &&create_info) {
 
     CommandPool pool;
     pool.command_pool = command_pool;
-    pool.rid = RIDServer::instance().new_id(RIDServer::COMMAND_POOL); // Generate a new RID for the command pool
+    pool.flags = create_info.flags;
 
-    command_pools.push_back(std::move(pool)); // Add the created command pool to the vector
-
-    return command_pools.back().rid; // Return the RID of the newly created command pool
+    return command_pools.emplace(std::move(pool)); // Add the created command pool and return its RID
 }
 
 CommandPoolBuilder CommandPoolServer::new_command_pool() {
@@ -91,15 +90,72 @@ CommandPoolBuilder CommandPoolServer::new_command_pool() {
 } // Create a new command pool builder
 
 CommandPool &CommandPoolServer::get_command_pool(RID rid) {
-    for (auto &pool : command_pools) {
-        if (pool.rid == rid) {
-            return pool; // Return the command pool if found
-        }
+    if (CommandPool *pool = command_pools.get(rid)) {
+        return *pool; // Return the command pool if found
     }
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Command pool with RID " << rid << " not found!" << std::endl;
     #endif
-    return *command_pools.end(); // Return an invalid command pool if not found
+    return command_pools.at(rid); // Return an invalid command pool if not found
+}
+
+CommandBuffer CommandPoolServer::acquire_command_buffer(RID pool, VkCommandBufferLevel level) {
+    CommandPool &command_pool = get_command_pool(pool);
+    std::vector<VkCommandBuffer> &free_buffers = command_pool.free_buffers[level];
+
+    CommandBuffer cmd_buffer;
+    if (!free_buffers.empty()) {
+        cmd_buffer.buffer = free_buffers.back();
+        free_buffers.pop_back();
+    } else {
+        cmd_buffer = allocate_command_buffer(level, pool);
+        if (cmd_buffer.buffer == VK_NULL_HANDLE) {
+            return cmd_buffer;
+        }
+    }
+
+    command_pool.used_buffers[level].push_back(cmd_buffer.buffer);
+    return cmd_buffer;
+}
+
+void CommandPoolServer::release_command_buffer(RID pool, CommandBuffer buffer, VkCommandBufferLevel level) {
+    CommandPool &command_pool = get_command_pool(pool);
+    if (!(command_pool.flags & VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT)) {
+        return; // Cannot be reset on its own, recycled by the next reset_command_pool
+    }
+
+    std::vector<VkCommandBuffer> &used_buffers = command_pool.used_buffers[level];
+    auto it = std::find(used_buffers.begin(), used_buffers.end(), buffer.buffer);
+    if (it == used_buffers.end()) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Command buffer was not acquired from pool " << pool << std::endl;
+        #endif
+        return;
+    }
+
+    *it = used_buffers.back();
+    used_buffers.pop_back();
+    command_pool.free_buffers[level].push_back(buffer.buffer); // Implicitly reset by its next begin
+}
+
+void CommandPoolServer::reset_command_pool(RID pool) {
+    CommandPool &command_pool = get_command_pool(pool);
+    if (command_pool.used_buffers[0].empty() && command_pool.used_buffers[1].empty()) {
+        return; // Nothing recorded since the last reset
+    }
+
+    if (vkResetCommandPool(device, command_pool.command_pool, 0) != VK_SUCCESS) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to reset command pool " << pool << std::endl;
+        #endif
+        return;
+    }
+
+    for (uint32_t level = 0; level < 2; ++level) {
+        std::vector<VkCommandBuffer> &used_buffers = command_pool.used_buffers[level];
+        command_pool.free_buffers[level].insert(command_pool.free_buffers[level].end(), used_buffers.begin(), used_buffers.end());
+        used_buffers.clear();
+    }
 }
 
 CommandPoolServer &CommandPoolServer::instance() {
@@ -0,0 +1,120 @@
+
+#ifdef ALCHEMIST_DEBUG
+#include <iostream>
+#endif // ALCHEMIST_DEBUG
+
+#include "server/deletion.hpp"
+
+#include "server/buffer.hpp"
+#include "server/mesh.hpp"
+#include "server/image.hpp"
+#include "server/framebuffer.hpp"
+#include "server/gpu_memory.hpp"
+#include "server/pipeline.hpp"
+#include "server/descriptor.hpp"
+
+DeletionQueue::DeletionQueue(uint32_t frames_in_flight) : frames_in_flight(frames_in_flight) {}
+
+DeletionQueue::~DeletionQueue() {
+    flush();
+}
+
+void DeletionQueue::release(RID rid) {
+    if (rid == RID_INVALID) {
+        return;
+    }
+    pending.push_back({rid, frame});
+}
+
+void DeletionQueue::release(RID rid, const GpuFuture &future) {
+    if (rid == RID_INVALID) {
+        return;
+    }
+    if (!future.valid()) {
+        release(rid); // No timeline, fall back on the frame
+        return;
+    }
+    pending_futures.push_back({rid, future});
+}
+
+void DeletionQueue::collect(uint64_t frame_count) {
+    frame = frame_count;
+
+    // Frame f is done once the fence of frame f + frames_in_flight, sharing its slot, has been waited on
+    while (!pending.empty() && pending.front().frame + frames_in_flight <= frame_count) {
+        destroy(pending.front().rid);
+        pending.pop_front();
+    }
+
+    for (size_t i = 0; i < pending_futures.size();) {
+        if (!pending_futures[i].future.is_ready()) {
+            ++i;
+            continue;
+        }
+        destroy(pending_futures[i].rid);
+        pending_futures[i] = pending_futures.back(); // Order does not matter, swap and pop
+        pending_futures.pop_back();
+    }
+}
+
+void DeletionQueue::flush() {
+    for (const PendingDeletion &deletion : pending) {
+        destroy(deletion.rid);
+    }
+    for (const PendingFutureDeletion &deletion : pending_futures) {
+        destroy(deletion.rid);
+    }
+    pending.clear();
+    pending_futures.clear();
+}
+
+size_t DeletionQueue::size() const {
+    return pending.size() + pending_futures.size();
+}
+
+void DeletionQueue::destroy(RID rid) {
+    switch (rid_type(rid)) {
+        case RIDServer::BUFFER:
+            BufferServer::instance().free_buffer(rid);
+            break;
+        case RIDServer::MESH:
+            MeshServer::instance().free_mesh(rid);
+            break;
+        case RIDServer::IMAGE:
+            ImageServer::instance().free_image(rid);
+            break;
+        case RIDServer::IMAGE_VIEW:
+            ImageViewServer::instance().free_image_view(rid);
+            break;
+        case RIDServer::FRAMEBUFFER:
+            FramebufferServer::instance().free_framebuffer(rid);
+            break;
+        case RIDServer::MEMORY:
+        case RIDServer::IMAGE_MEMORY:
+            GpuMemoryServer::instance().free_block(rid);
+            break;
+        case RIDServer::PIPELINE:
+            PipelineServer::instance().free_pipeline(rid);
+            break;
+        case RIDServer::PIPELINE_LAYOUT:
+            PipelineLayoutServer::instance().free_pipeline_layout(rid);
+            break;
+        case RIDServer::DESCRIPTOR_SET:
+            DescriptorServer::instance().free_descriptor(rid);
+            break;
+        case RIDServer::DESCRIPTOR_LAYOUT:
+            DescriptorLayoutServer::instance().free_descriptor_layout(rid);
+            break;
+        default:
+            #ifdef ALCHEMIST_DEBUG
+            std::cerr << "Deferred deletion of RID " << rid << " is not supported!" << std::endl;
+            #endif
+            break;
+    }
+}
+
+DeletionQueue &DeletionQueue::instance() {
+    return *__instance; // Return the singleton instance
+}
+
+std::unique_ptr<DeletionQueue> DeletionQueue::__instance = nullptr; // Singleton instance of DeletionQueue
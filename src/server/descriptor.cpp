@@ -3,8 +3,12 @@
 #include <iostream> // Include for debug output
 #endif // ALCHEMIST_DEBUG
 
+#include <algorithm>
+
 #include "server/descriptor.hpp"
 
+#include "memory/state_key.hpp"
+
 DescriptorUpdate Descriptor::update() const {
     return DescriptorUpdate(*this);
 }
@@ -183,11 +187,8 @@ RID DescriptorPoolBuilder::build() const {
 
     DescriptorPool pool;
     pool.pool = descriptor_pool;
-    pool.rid = RIDServer::instance().new_id(RIDServer::DESCRIPTOR_POOL); // Create a new RID for the descriptor pool
 
-    server.descriptor_pools.emplace_back(std::move(pool)); // Add the pool to the server's pools vector
-
-    return pool.rid; // Return the RID of the newly created descriptor pool
+    return server.descriptor_pools.emplace(std::move(pool)); // Add the pool to the server's pools and return its RID
 }
 
 
@@ -241,21 +242,7 @@ RID DescriptorLayoutBuilder::build() const {
     create_info.bindingCount = static_cast<uint32_t>(bindings.size());
     create_info.pBindings = bindings.data();
 
-    VkDescriptorSetLayout descriptor_set_layout;
-    if (vkCreateDescriptorSetLayout(server.device, &create_info, nullptr, &descriptor_set_layout) != VK_SUCCESS) {
-    #ifdef ALCHEMIST_DEBUG
-        std::cerr << "Failed to create descriptor set layout." << std::endl;
-    #endif
-        return RID_INVALID; // Return an invalid RID if creation fails
-    }
-
-    DescriptorLayout layout;
-    layout.layout = descriptor_set_layout;
-    layout.rid = RIDServer::instance().new_id(RIDServer::DESCRIPTOR_LAYOUT); // Create a new RID for the descriptor layout
-
-    server.descriptor_layouts.emplace_back(std::move(layout)); // Add the layout to the server's layouts vector
-
-    return layout.rid; // Return the RID of the newly created descriptor layout
+    return server.new_descriptor_layout(create_info); // Shared with any identical layout
 }
 
 DescriptorPoolServer::DescriptorPoolServer(VkDevice device) : device(device) {}
@@ -271,7 +258,6 @@ DescriptorPoolServer::~DescriptorPoolServer() {
 
 RID DescriptorPoolServer::new_descriptor_pool(const VkDescriptorPoolCreateInfo &create_info) {
     VkDescriptorPool descriptor_pool;
-    RID rid = RIDServer::instance().new_id(RIDServer::DESCRIPTOR_POOL);
 
     if (vkCreateDescriptorPool(device, &create_info, nullptr, &descriptor_pool) != VK_SUCCESS) {
     #ifdef ALCHEMIST_DEBUG
@@ -282,16 +268,12 @@ RID DescriptorPoolServer::new_descriptor_pool(const VkDescriptorPoolCreateInfo &
 
     DescriptorPool pool;
     pool.pool = descriptor_pool;
-    pool.rid = rid;
 
-    descriptor_pools.emplace_back(std::move(pool)); // Add the created pool to the pools vector
-
-    return rid; // Return the RID of the newly created descriptor pool
+    return descriptor_pools.emplace(std::move(pool)); // Add the created pool to the pools and return its RID
 }
 
 RID DescriptorPoolServer::new_descriptor_pool(VkDescriptorPoolCreateInfo &&create_info) {
     VkDescriptorPool descriptor_pool;
-    RID rid = RIDServer::instance().new_id(RIDServer::DESCRIPTOR_POOL);
 
     if (vkCreateDescriptorPool(device, &create_info, nullptr, &descriptor_pool) != VK_SUCCESS) {
     #ifdef ALCHEMIST_DEBUG
@@ -302,27 +284,22 @@ RID DescriptorPoolServer::new_descriptor_pool(VkDescriptorPoolCreateInfo &&creat
 
     DescriptorPool pool;
     pool.pool = descriptor_pool;
-    pool.rid = rid;
-
-    descriptor_pools.emplace_back(std::move(pool)); // Add the created pool to the pools vector
 
-    return rid; // Return the RID of the newly created descriptor pool
+    return descriptor_pools.emplace(std::move(pool)); // Add the created pool to the pools and return its RID
 }
 
 DescriptorPoolBuilder DescriptorPoolServer::new_descriptor_pool() {
     return DescriptorPoolBuilder(*this); // Return a DescriptorPoolBuilder instance for creating descriptor pools
 }
 
-const DescriptorPool &DescriptorPoolServer::get_descriptor_pool(RID rid) {
-    for (const auto &pool : descriptor_pools) {
-        if (pool.rid == rid) {
-            return pool; // Return the descriptor pool if found
-        }
+const DescriptorPool &DescriptorPoolServer::get_descriptor_pool(RID rid) const {
+    if (const DescriptorPool *pool = descriptor_pools.get(rid)) {
+        return *pool; // Return the descriptor pool if found
     }
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Descriptor pool with RID " << rid << " not found!" << std::endl;
     #endif
-    return descriptor_pools.front(); // Return the first pool as a fallback (should be handled better)
+    return descriptor_pools.at(rid); // Invalid pool as a fallback
 }
 
 DescriptorPoolServer &DescriptorPoolServer::instance() {
@@ -344,29 +321,37 @@ DescriptorLayoutServer::~DescriptorLayoutServer() {
     }
 }
 
-RID DescriptorLayoutServer::new_descriptor_layout(const VkDescriptorSetLayoutCreateInfo &create_info) {
-    VkDescriptorSetLayout descriptor_set_layout;
-    RID rid = RIDServer::instance().new_id(RIDServer::DESCRIPTOR_LAYOUT);
-
-    if (vkCreateDescriptorSetLayout(device, &create_info, nullptr, &descriptor_set_layout) != VK_SUCCESS) {
-    #ifdef ALCHEMIST_DEBUG
-        std::cerr << "Failed to create descriptor set layout." << std::endl;
-    #endif
-        return RID_INVALID; // Return an invalid RID on failure
+static std::string descriptor_layout_key(const VkDescriptorSetLayoutCreateInfo &create_info) {
+    // Binding order does not change the layout, sort so both orders share a key
+    std::vector<const VkDescriptorSetLayoutBinding *> bindings;
+    for (uint32_t i = 0; i < create_info.bindingCount; ++i) {
+        bindings.push_back(&create_info.pBindings[i]);
     }
-
-    DescriptorLayout layout;
-    layout.layout = descriptor_set_layout;
-    layout.rid = rid;
-
-    descriptor_layouts.emplace_back(std::move(layout)); // Add the layout to the server's layouts vector
-
-    return rid; // Return the RID of the newly created descriptor layout
+    std::sort(bindings.begin(), bindings.end(), [](const auto *a, const auto *b) { return a->binding < b->binding; });
+
+    StateKey key;
+    key.add(create_info.flags).add(create_info.bindingCount);
+    for (const VkDescriptorSetLayoutBinding *binding : bindings) {
+        key.add(binding->binding)
+            .add(binding->descriptorType)
+            .add(binding->descriptorCount)
+            .add(binding->stageFlags)
+            .add_array(binding->pImmutableSamplers, binding->pImmutableSamplers ? binding->descriptorCount : 0);
+    }
+    return std::move(key.bytes);
 }
 
-RID DescriptorLayoutServer::new_descriptor_layout(VkDescriptorSetLayoutCreateInfo &&create_info) {
+RID DescriptorLayoutServer::new_descriptor_layout(const VkDescriptorSetLayoutCreateInfo &create_info) {
+    std::string key = descriptor_layout_key(create_info);
+    auto it = layout_keys.find(key);
+    if (it != layout_keys.end()) {
+        if (DescriptorLayout *shared = descriptor_layouts.get(it->second)) {
+            shared->references++;
+            return it->second; // Same bindings, same layout
+        }
+    }
+
     VkDescriptorSetLayout descriptor_set_layout;
-    RID rid = RIDServer::instance().new_id(RIDServer::DESCRIPTOR_LAYOUT);
 
     if (vkCreateDescriptorSetLayout(device, &create_info, nullptr, &descriptor_set_layout) != VK_SUCCESS) {
     #ifdef ALCHEMIST_DEBUG
@@ -377,27 +362,44 @@ RID DescriptorLayoutServer::new_descriptor_layout(VkDescriptorSetLayoutCreateInf
 
     DescriptorLayout layout;
     layout.layout = descriptor_set_layout;
-    layout.rid = rid;
 
-    descriptor_layouts.emplace_back(std::move(layout)); // Add the layout to the server's layouts vector
+    RID rid = descriptor_layouts.emplace(std::move(layout)); // Add the layout to the server's layouts
+    layout_keys[std::move(key)] = rid;
+    return rid;
+}
 
-    return rid; // Return the RID of the newly created descriptor layout
+RID DescriptorLayoutServer::new_descriptor_layout(VkDescriptorSetLayoutCreateInfo &&create_info) {
+    return new_descriptor_layout(static_cast<const VkDescriptorSetLayoutCreateInfo &>(create_info));
 }
 
 DescriptorLayoutBuilder DescriptorLayoutServer::new_descriptor_layout() {
     return DescriptorLayoutBuilder(*this); // Create a new descriptor layout builder
 } // Create a new descriptor layout builder
 
-const DescriptorLayout &DescriptorLayoutServer::get_descriptor_layout(RID rid) {
-    for (const auto &layout : descriptor_layouts) {
-        if (layout.rid == rid) {
-            return layout; // Return the descriptor layout if found
-        }
+void DescriptorLayoutServer::free_descriptor_layout(RID rid) {
+    DescriptorLayout *layout = descriptor_layouts.get(rid);
+    if (layout == nullptr) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Descriptor layout with RID " << rid << " not found for release!" << std::endl;
+        #endif
+        return;
+    }
+
+    if (--layout->references > 0) {
+        return; // Still used by another build
+    }
+    vkDestroyDescriptorSetLayout(device, layout->layout, nullptr);
+    descriptor_layouts.erase(rid); // Its key goes stale, new_descriptor_layout checks the RID is still alive
+}
+
+const DescriptorLayout &DescriptorLayoutServer::get_descriptor_layout(RID rid) const {
+    if (const DescriptorLayout *layout = descriptor_layouts.get(rid)) {
+        return *layout; // Return the descriptor layout if found
     }
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Descriptor layout with RID " << rid << " not found!" << std::endl;
     #endif
-    return descriptor_layouts.front(); // Return the first layout as a fallback (should be handled better)
+    return descriptor_layouts.at(rid); // Invalid layout as a fallback
 }
 
 DescriptorLayoutServer &DescriptorLayoutServer::instance() {
@@ -438,7 +440,6 @@ RID DescriptorServer::new_descriptor(RID pool, RID layout) {
     Descriptor descriptor;
     descriptor.descriptor_set = descriptor_set;
     descriptor.device = device; // Set the Vulkan device for the descriptor
-    descriptor.rid = RIDServer::instance().new_id(RIDServer::DESCRIPTOR_SET); // Create a new RID for the descriptor set
     descriptor.pool_rid = pool; // Set the pool RID
     descriptor.layout_rid = layout; // Set the layout RID
 
@@ -446,9 +447,7 @@ RID DescriptorServer::new_descriptor(RID pool, RID layout) {
     std::cout << "Created descriptor set with Pool " << pool << " and " << layout << std::endl;
     #endif
 
-    descriptors.push_back(descriptor); // Add the created descriptor to the server's descriptors vector
-
-    return descriptors.back().rid; // Return the RID of the newly created descriptor set
+    return descriptors.emplace(std::move(descriptor)); // Add the created descriptor to the server's descriptors and return its RID
 }
 
 void DescriptorServer::emplace_descriptors(std::vector<RID> &descriptors, RID pool, RID layout, uint32_t count) {
@@ -469,25 +468,34 @@ void DescriptorServer::emplace_descriptors(std::vector<RID> &descriptors, RID po
     for (const auto &descriptor_set : descriptor_sets) {
         Descriptor descriptor;
         descriptor.descriptor_set = descriptor_set;
-        descriptor.rid = RIDServer::instance().new_id(RIDServer::DESCRIPTOR_SET); // Create a new RID for the descriptor set
+        descriptor.device = device; // Set the Vulkan device for the descriptor
         descriptor.pool_rid = pool; // Set the pool RID
         descriptor.layout_rid = layout; // Set the layout RID
 
-        this->descriptors.push_back(descriptor); // Add the created descriptor to the vector
-        descriptors.push_back(descriptor.rid);
+        descriptors.push_back(this->descriptors.emplace(std::move(descriptor))); // Add the created descriptor to the slot map
     }
 }
 
+void DescriptorServer::free_descriptor(RID rid) {
+    if (const Descriptor *descriptor = descriptors.get(rid)) {
+        const DescriptorPool &pool = DescriptorPoolServer::instance().get_descriptor_pool(descriptor->pool_rid);
+        vkFreeDescriptorSets(device, pool.pool, 1, &descriptor->descriptor_set); // Pools are created with FREE_DESCRIPTOR_SET
+        descriptors.erase(rid);
+        return;
+    }
+    #ifdef ALCHEMIST_DEBUG
+    std::cerr << "Descriptor with RID " << rid << " not found for release!" << std::endl;
+    #endif
+}
+
 const Descriptor &DescriptorServer::get_descriptor(RID rid) const {
-    for (const auto &descriptor : descriptors) {
-        if (descriptor.rid == rid) {
-            return descriptor; // Return the descriptor if found
-        }
+    if (const Descriptor *descriptor = descriptors.get(rid)) {
+        return *descriptor; // Return the descriptor if found
     }
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Descriptor with RID " << rid << " not found!" << std::endl;
     #endif
-    return descriptors.front(); // Return the first descriptor as a fallback (should be handled better)
+    return descriptors.at(rid); // Invalid descriptor as a fallback
 }
 
 DescriptorServer &DescriptorServer::instance() {
@@ -114,10 +114,8 @@ RID FramebufferServer::new_framebuffer(const VkFramebufferCreateInfo &create_inf
 
     Framebuffer fb;
     fb.framebuffer = framebuffer;
-    fb.rid = RIDServer::instance().new_id(RIDServer::FRAMEBUFFER);
-    framebuffers.push_back(fb);
 
-    return fb.rid;
+    return framebuffers.emplace(std::move(fb));
 }
 
 RID FramebufferServer::new_framebuffer(VkFramebufferCreateInfo &&create_info) {
@@ -132,10 +130,19 @@ RID FramebufferServer::new_framebuffer(VkFramebufferCreateInfo &&create_info) {
 
     Framebuffer fb;
     fb.framebuffer = framebuffer;
-    fb.rid = RIDServer::instance().new_id(RIDServer::FRAMEBUFFER);
-    framebuffers.push_back(fb);
 
-    return fb.rid;
+    return framebuffers.emplace(std::move(fb));
+}
+
+void FramebufferServer::free_framebuffer(RID rid) {
+    if (const Framebuffer *fb = framebuffers.get(rid)) {
+        vkDestroyFramebuffer(device, fb->framebuffer, nullptr);
+        framebuffers.erase(rid);
+        return;
+    }
+    #ifdef ALCHEMIST_DEBUG
+    std::cerr << "Framebuffer with RID " << rid << " not found for release!" << std::endl;
+    #endif
 }
 
 FramebufferBuilder FramebufferServer::new_framebuffer(uint32_t width, uint32_t height, uint32_t layers) {
@@ -143,13 +150,13 @@ FramebufferBuilder FramebufferServer::new_framebuffer(uint32_t width, uint32_t h
 }
 
 const Framebuffer &FramebufferServer::get_framebuffer(RID rid) const {
-    if (rid >= framebuffers.size() || framebuffers[rid].rid == RID_INVALID) {
+    if (const Framebuffer *fb = framebuffers.get(rid)) {
+        return *fb;
+    }
     #ifdef ALCHEMIST_DEBUG
-        std::cerr << "Invalid framebuffer RID: " << rid << std::endl;
+    std::cerr << "Invalid framebuffer RID: " << rid << std::endl;
     #endif
-        return framebuffers[0]; // Return the first framebuffer or handle this case appropriately
-    }
-    return framebuffers[rid];
+    return framebuffers.at(rid); // Invalid framebuffer as a fallback
 }
 
 FramebufferServer &FramebufferServer::instance() {
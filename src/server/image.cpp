@@ -94,7 +94,7 @@ RID ImageBuilder::build() const {
     #ifdef ALCHEMIST_DEBUG
         std::cerr << "Image format must be set before building!" << std::endl;
     #endif
-        return UINT32_MAX;
+        return RID_INVALID;
     }
 
     return server.new_image(create_info); // Create the image using the server
@@ -173,14 +173,14 @@ RID ImageViewBuilder::build() const {
     #ifdef ALCHEMIST_DEBUG
         std::cerr << "Image must be set before building ImageView!" << std::endl;
     #endif
-        return UINT32_MAX; // Invalid RID
+        return RID_INVALID; // Invalid RID
     }
 
     if (create_info.format == VK_FORMAT_UNDEFINED) {
     #ifdef ALCHEMIST_DEBUG
         std::cerr << "Image format must be set before building ImageView!" << std::endl;
     #endif
-        return UINT32_MAX; // Invalid RID
+        return RID_INVALID; // Invalid RID
     }
 
     return server.new_image_view(create_info); // Create the image view using the server
@@ -344,13 +344,6 @@ RID SamplerBuilder::build() const {
 
 
 
-Image::~Image() {
-    RIDServer::instance().free(RIDServer::IMAGE, rid);
-    RIDServer::instance().free(RIDServer::MEMORY, memory_rid);
-}
-
-
-
 CmdTransitionImageLayout::CmdTransitionImageLayout(VkImage image) : image(image) {
     barrier = {};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -441,45 +434,19 @@ CmdUploadImage::CmdUploadImage(VkImage image) : image(image) {
     copy_region.imageSubresource.layerCount = 1; // Default layer count
 }
 
-CmdUploadImage::~CmdUploadImage() {
-    vkDestroyBuffer(ImageServer::instance().device, staging, nullptr); // Clean up the staging buffer
-    if (memory_rid != RID_INVALID) {
-        GpuMemoryServer::instance().free_block(memory_rid); // Free the memory block associated with the staging buffer
-    }
-}
-
 CmdUploadImage &CmdUploadImage::upload_data(VkDevice device, VkPhysicalDevice physical_device, VkDeviceSize size, const void *data) {
-    RID rid;
-
-    VkBufferCreateInfo buffer_info = {};
-    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    buffer_info.size = size;
-    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT; // Staging buffer for transfer
-    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-    if (vkCreateBuffer(device, &buffer_info, nullptr, &staging) != VK_SUCCESS) {
+    StagingRegion region = ImageServer::instance().staging.allocate(size); // 16 bytes covers the texel size of every format used
+    if (region.buffer == VK_NULL_HANDLE) {
     #ifdef ALCHEMIST_DEBUG
-        std::cerr << "Failed to create staging buffer!" << std::endl;
+        std::cerr << "Failed to allocate staging memory!" << std::endl;
     #endif
         return *this;
     }
 
-    VkMemoryRequirements mem_requirements;
-    vkGetBufferMemoryRequirements(device, staging, &mem_requirements);
-
-    memory_rid = GpuMemoryServer::instance().allocate_block<VkBuffer>(
-        size,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        find_memory_type(physical_device, mem_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
-    );
-    GpuMemoryServer::instance().bind(memory_rid, mem_requirements, staging);
-    
+    staging = region.buffer;
+    copy_region.bufferOffset = region.offset; // Offset of the region in the staging ring
 
-    // Copy data to the staging buffer
-    void *mapped_data;
-    GpuMemoryServer::instance().map(memory_rid, &mapped_data);
-    memcpy(mapped_data, data, size);
-    GpuMemoryServer::instance().unmap(memory_rid);
+    memcpy(region.data, data, size); // The ring is persistently mapped and coherent
 
     return *this; // Return the command for chaining
 }
@@ -500,7 +467,7 @@ CmdUploadImage &CmdUploadImage::set_extent(VkExtent3D image_extent) {
 
 
 
-ImageServer::ImageServer(VkDevice device, VkPhysicalDevice physical_device) : device(device), physical_device(physical_device) {}
+ImageServer::ImageServer(VkDevice device, VkPhysicalDevice physical_device) : staging(device, physical_device), device(device), physical_device(physical_device) {}
 ImageServer::~ImageServer() {
     for (const auto &image : images) {
         #ifdef ALCHEMIST_DEBUG
@@ -513,7 +480,6 @@ ImageServer::~ImageServer() {
 
 RID ImageServer::new_image(const VkImageCreateInfo &create_info) {
     VkImage image;
-    RID rid = RIDServer::instance().new_id(RIDServer::IMAGE);
 
     if (vkCreateImage(device, &create_info, nullptr, &image) != VK_SUCCESS) {
     #ifdef ALCHEMIST_DEBUG
@@ -522,15 +488,12 @@ RID ImageServer::new_image(const VkImageCreateInfo &create_info) {
         return RID_INVALID;
     }
 
-    images.emplace_back(image, rid, 0); // Add the created image to the images vector
-
-    return rid;
+    return images.emplace(image, RID_INVALID, RID_INVALID); // Add the created image to the images and return its RID
 }
 
 RID ImageServer::new_image(VkImageCreateInfo &&create_info) {
     VkImage image;
     VkDeviceSize size = create_info.extent.width * create_info.extent.height;
-    RID rid = RIDServer::instance().new_id(RIDServer::IMAGE);
 
     if (create_info.format == VK_FORMAT_R8G8B8_UNORM) {
         size *= 3;
@@ -540,14 +503,14 @@ RID ImageServer::new_image(VkImageCreateInfo &&create_info) {
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Unsupported image format!" << std::endl;
         #endif
-        return UINT32_MAX; // Return 0 if the format is unsupported
+        return RID_INVALID; // Return an invalid RID if the format is unsupported
     }
 
     if (vkCreateImage(device, &create_info, nullptr, &image) != VK_SUCCESS) {
     #ifdef ALCHEMIST_DEBUG
         std::cerr << "Failed to create image!" << std::endl;
     #endif
-        return UINT32_MAX;
+        return RID_INVALID;
     }
 
     // VkMemoryRequirements mem_requirements;
@@ -563,9 +526,23 @@ RID ImageServer::new_image(VkImageCreateInfo &&create_info) {
     //     return RID_INVALID; // Return 0 if the binding fails
     // }
 
-    images.emplace_back(image, rid, 0); // Add the created image to the images vector
+    return images.emplace(image, RID_INVALID, RID_INVALID); // Add the created image to the images and return its RID
+}
+
+void ImageServer::free_image(RID rid) {
+    Image *image = images.get(rid);
+    if (image == nullptr) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Image with RID " << rid << " not found for release!" << std::endl;
+        #endif
+        return;
+    }
 
-    return rid;
+    if (image->memory_rid != RID_INVALID && image->bind_rid != RID_INVALID) {
+        GpuMemoryServer::instance().unbind(image->memory_rid, image->bind_rid); // Give the range back to the block
+    }
+    vkDestroyImage(device, image->image, nullptr);
+    images.erase(rid);
 }
 
 ImageBuilder ImageServer::new_image() {
@@ -573,23 +550,19 @@ ImageBuilder ImageServer::new_image() {
 }
 
 const Image &ImageServer::get_image(RID rid) const {
-    for (const auto &image : images) {
-        if (image.rid == rid) {
-            return image; // Return the image if found
-        }
+    if (const Image *image = images.get(rid)) {
+        return *image; // Return the image if found
     }
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Image with RID " << rid << " not found!" << std::endl;
     #endif
-    return *images.end(); // Return the last image as a fallback (or could throw an exception)
+    return images.at(rid); // Invalid image as a fallback
 }
 
 void ImageServer::get_requirements(RID rid, VkMemoryRequirements &requirements) const {
-    for (const auto &image : images) {
-        if (image.rid == rid) {
-            vkGetImageMemoryRequirements(device, image.image, &requirements);
-            return; // Return the requirements if the image is found
-        }
+    if (const Image *image = images.get(rid)) {
+        vkGetImageMemoryRequirements(device, image->image, &requirements);
+        return; // Return the requirements if the image is found
     }
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Image with RID " << rid << " not found for memory requirements!" << std::endl;
@@ -599,65 +572,63 @@ void ImageServer::get_requirements(RID rid, VkMemoryRequirements &requirements)
 void ImageServer::bind_image(RID image, RID memory) {
     VkMemoryRequirements mem_requirements;
 
-    for (auto &img : images) {
-        if (img.rid == image) {
-            vkGetImageMemoryRequirements(device, img.image, &mem_requirements);
-            img.memory_rid = memory; // Bind the memory to the image
-            RID bind_rid = GpuMemoryServer::instance().bind(memory, mem_requirements, img.image);
-
-            if (bind_rid == RID_INVALID) {
-                #ifdef ALCHEMIST_DEBUG
-                std::cerr << "Failed to bind image memory for RID: " << image << std::endl;
-                #endif
-                return; // Return if binding fails
-            }
-            #ifdef ALCHEMIST_DEBUG
-            std::cout << "Image with RID " << image << " bound to memory with RID " << memory << std::endl;
-            #endif
-
-            return;
-        }
+    Image *img = images.get(image);
+    if (img == nullptr) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Image with RID " << image << " not found for binding!" << std::endl;
+        #endif
+        return;
     }
 
+    vkGetImageMemoryRequirements(device, img->image, &mem_requirements);
+    img->memory_rid = memory; // Bind the memory to the image
+    RID bind_rid = GpuMemoryServer::instance().bind(memory, mem_requirements, img->image);
+    img->bind_rid = bind_rid; // Keep the bind so the range can be released later
+
+    if (bind_rid == RID_INVALID) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to bind image memory for RID: " << image << std::endl;
+        #endif
+        return; // Return if binding fails
+    }
     #ifdef ALCHEMIST_DEBUG
-    std::cerr << "Image with RID " << image << " not found for binding!" << std::endl;
+    std::cout << "Image with RID " << image << " bound to memory with RID " << memory << std::endl;
     #endif
 }
 
 void ImageServer::bind_best(RID image, VkMemoryPropertyFlags flags) {
     VkMemoryRequirements mem_requirements;
 
-    for (auto &img : images) {
-        if (img.rid == image) {
-            vkGetImageMemoryRequirements(device, img.image, &mem_requirements);
+    Image *img = images.get(image);
+    if (img == nullptr) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Image with RID " << image << " not found for binding!" << std::endl;
+        #endif
+        return;
+    }
 
-            img.memory_rid = GpuMemoryServer::instance().find_best<VkImage>(mem_requirements, flags);
+    vkGetImageMemoryRequirements(device, img->image, &mem_requirements);
 
-            if (img.memory_rid == RID_INVALID) {
-                #ifdef ALCHEMIST_DEBUG
-                std::cerr << "Failed to find suitable memory for image with RID: " << image << std::endl;
-                #endif
-                return; // Return if no suitable memory is found
-            }
-            
-            RID bind_rid = GpuMemoryServer::instance().bind(img.memory_rid, mem_requirements, img.image);
-
-            if (bind_rid == RID_INVALID) {
-                #ifdef ALCHEMIST_DEBUG
-                std::cerr << "Failed to bind image memory for RID: " << image << std::endl;
-                #endif
-                return; // Return if binding fails
-            }
-            #ifdef ALCHEMIST_DEBUG
-            std::cout << "Image with RID " << image << " bound to best memory with RID " << img.memory_rid << std::endl;
-            #endif
+    img->memory_rid = GpuMemoryServer::instance().find_best<VkImage>(mem_requirements, flags);
 
-            return;
-        }
+    if (img->memory_rid == RID_INVALID) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to find suitable memory for image with RID: " << image << std::endl;
+        #endif
+        return; // Return if no suitable memory is found
     }
+    
+    RID bind_rid = GpuMemoryServer::instance().bind(img->memory_rid, mem_requirements, img->image);
+    img->bind_rid = bind_rid; // Keep the bind so the range can be released later
 
+    if (bind_rid == RID_INVALID) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to bind image memory for RID: " << image << std::endl;
+        #endif
+        return; // Return if binding fails
+    }
     #ifdef ALCHEMIST_DEBUG
-    std::cerr << "Image with RID " << image << " not found for binding!" << std::endl;
+    std::cout << "Image with RID " << image << " bound to best memory with RID " << img->memory_rid << std::endl;
     #endif
 }
 
@@ -700,14 +671,16 @@ void ImageServer::execute_commands(VkCommandBuffer cmd_buffer) {
             transition_index++; // Move to the next transition command
         } else if (command == ImageCommandType::UPLOAD) {
             const auto &data = upload_commands[upload_index];
-            vkCmdCopyBufferToImage(
-                cmd_buffer,
-                data.staging,
-                data.image,
-                data.layout,
-                1, // One region
-                &data.copy_region
-            );
+            if (data.staging != VK_NULL_HANDLE) { // Skip uploads that never got staging memory
+                vkCmdCopyBufferToImage(
+                    cmd_buffer,
+                    data.staging,
+                    data.image,
+                    data.layout,
+                    1, // One region
+                    &data.copy_region
+                );
+            }
             upload_index++; // Move to the next upload command
         } else {
             #ifdef ALCHEMIST_DEBUG
@@ -717,6 +690,61 @@ void ImageServer::execute_commands(VkCommandBuffer cmd_buffer) {
     }
 }
 
+void ImageServer::ownership_barriers(uint32_t src_family, uint32_t dst_family, std::vector<VkImageMemoryBarrier> &release, std::vector<VkImageMemoryBarrier> &acquire) const {
+    size_t first = acquire.size(); // Only dedupe against the barriers added by this call
+    uint32_t transition_index = 0;
+    uint32_t upload_index = 0;
+
+    for (const auto &command : command_types) {
+        VkImage image;
+        VkImageLayout layout;
+        VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+
+        if (command == ImageCommandType::TRANSITION_LAYOUT) {
+            const auto &data = transition_commands[transition_index++];
+            image = data.image;
+            layout = data.barrier.newLayout;
+            range.aspectMask = data.barrier.subresourceRange.aspectMask;
+        } else {
+            const auto &data = upload_commands[upload_index++];
+            image = data.image;
+            layout = data.layout;
+            range.aspectMask = data.copy_region.imageSubresource.aspectMask;
+        }
+
+        VkImageMemoryBarrier *known = nullptr;
+        for (size_t i = first; i < acquire.size(); ++i) {
+            if (acquire[i].image == image) {
+                known = &acquire[i];
+            }
+        }
+        if (known) {
+            known->oldLayout = layout; // Later commands decide the layout the image is handed over in
+            known->newLayout = layout;
+            release[known - acquire.data()].oldLayout = layout;
+            release[known - acquire.data()].newLayout = layout;
+            continue;
+        }
+
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = src_family;
+        barrier.dstQueueFamilyIndex = dst_family;
+        barrier.image = image;
+        barrier.oldLayout = layout; // No layout change, only ownership
+        barrier.newLayout = layout;
+        barrier.subresourceRange = range;
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0; // Ignored on the releasing queue
+        release.push_back(barrier);
+
+        barrier.srcAccessMask = 0; // Ignored on the acquiring queue
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        acquire.push_back(barrier);
+    }
+}
+
 void ImageServer::clear_commands() {
     upload_commands.clear();
     transition_commands.clear();
@@ -745,34 +773,39 @@ ImageViewServer::~ImageViewServer() {
 
 RID ImageViewServer::new_image_view(const VkImageViewCreateInfo &create_info) {
     VkImageView image_view;
-    RID rid = RIDServer::instance().new_id(RIDServer::IMAGE_VIEW);
 
     if (vkCreateImageView(device, &create_info, nullptr, &image_view) != VK_SUCCESS) {
     #ifdef ALCHEMIST_DEBUG
         std::cerr << "Failed to create image view!" << std::endl;
     #endif
-        return UINT32_MAX; // Return 0 if the creation fails
+        return RID_INVALID; // Return an invalid RID if the creation fails
     }
 
-    image_views.emplace_back(image_view, rid); // Add the created image view to the image views vector
-
-    return rid;
+    return image_views.emplace(image_view, RID_INVALID); // Add the created image view and return its RID
 }
 
 RID ImageViewServer::new_image_view(VkImageViewCreateInfo &&create_info) {
     VkImageView image_view;
-    RID rid = RIDServer::instance().new_id(RIDServer::IMAGE_VIEW);
 
     if (vkCreateImageView(device, &create_info, nullptr, &image_view) != VK_SUCCESS) {
     #ifdef ALCHEMIST_DEBUG
         std::cerr << "Failed to create image view!" << std::endl;
     #endif
-        return UINT32_MAX; // Return 0 if the creation fails
+        return RID_INVALID; // Return an invalid RID if the creation fails
     }
 
-    image_views.emplace_back(image_view, rid); // Add the created image view to the image views vector
+    return image_views.emplace(image_view, RID_INVALID); // Add the created image view and return its RID
+}
 
-    return rid;
+void ImageViewServer::free_image_view(RID rid) {
+    if (const ImageView *view = image_views.get(rid)) {
+        vkDestroyImageView(device, view->view, nullptr);
+        image_views.erase(rid);
+        return;
+    }
+    #ifdef ALCHEMIST_DEBUG
+    std::cerr << "ImageView with RID " << rid << " not found for release!" << std::endl;
+    #endif
 }
 
 ImageViewBuilder ImageViewServer::new_image_view() {
@@ -780,15 +813,13 @@ ImageViewBuilder ImageViewServer::new_image_view() {
 }
 
 const ImageView &ImageViewServer::get_image_view(RID rid) const {
-    for (const auto &view : image_views) {
-        if (view.rid == rid) {
-            return view; // Return the image view if found
-        }
+    if (const ImageView *view = image_views.get(rid)) {
+        return *view; // Return the image view if found
     }
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "ImageView with RID " << rid << " not found!" << std::endl;
     #endif
-    return *image_views.end(); // Return the last image view as a fallback (or could throw an exception)
+    return image_views.at(rid); // Invalid image view as a fallback
 }
 
 ImageViewServer &ImageViewServer::instance() {
@@ -815,34 +846,28 @@ SamplerServer::~SamplerServer() {
 
 RID SamplerServer::new_sampler(const VkSamplerCreateInfo &create_info) {
     VkSampler sampler;
-    RID rid = RIDServer::instance().new_id(RIDServer::SAMPLER);
 
     if (vkCreateSampler(device, &create_info, nullptr, &sampler) != VK_SUCCESS) {
     #ifdef ALCHEMIST_DEBUG
         std::cerr << "Failed to create sampler!" << std::endl;
     #endif
-        return UINT32_MAX; // Return 0 if the creation fails
+        return RID_INVALID; // Return an invalid RID if the creation fails
     }
 
-    samplers.emplace_back(sampler, rid); // Add the created sampler to the samplers vector
-
-    return rid;
+    return samplers.emplace(sampler, RID_INVALID); // Add the created sampler and return its RID
 }
 
 RID SamplerServer::new_sampler(VkSamplerCreateInfo &&create_info) {
-    VkSampler sampler;static 
-    RID rid = RIDServer::instance().new_id(RIDServer::SAMPLER);
+    VkSampler sampler;
 
     if (vkCreateSampler(device, &create_info, nullptr, &sampler) != VK_SUCCESS) {
     #ifdef ALCHEMIST_DEBUG
         std::cerr << "Failed to create sampler!" << std::endl;
     #endif
-        return UINT32_MAX; // Return 0 if the creation fails
+        return RID_INVALID; // Return an invalid RID if the creation fails
     }
 
-    samplers.emplace_back(sampler, rid); // Add the created sampler to the samplers vector
-
-    return rid;
+    return samplers.emplace(sampler, RID_INVALID); // Add the created sampler and return its RID
 }
 
 SamplerBuilder SamplerServer::new_sampler() {
@@ -850,15 +875,13 @@ SamplerBuilder SamplerServer::new_sampler() {
 }
 
 const Sampler &SamplerServer::get_sampler(RID rid) const {
-    for (const auto &sampler : samplers) {
-        if (sampler.rid == rid) {
-            return sampler; // Return the sampler if found
-        }
+    if (const Sampler *sampler = samplers.get(rid)) {
+        return *sampler; // Return the sampler if found
     }
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Sampler with RID " << rid << " not found!" << std::endl;
     #endif
-    return *samplers.end(); // Return the last sampler as a fallback (or could throw an exception)
+    return samplers.at(rid); // Invalid sampler as a fallback
 }
 
 SamplerServer &SamplerServer::instance() {
@@ -4,47 +4,23 @@
 #endif // ALCHEMIST_DEBUG
 
 #include "server/mesh.hpp"
+#include "server/mesh_optimizer.hpp"
 #include "server/buffer.hpp"
 
-Mesh::~Mesh() {
-    if (rid != RID_INVALID) {
-        #ifdef ALCHEMIST_DEBUG
-        std::cout << "Destroying mesh with RID: " << rid << std::endl;
-        #endif
-        RIDServer::instance().free(RIDServer::MESH, rid); // Free the RID of the mesh
-    }
-    if (buffer != RID_INVALID) {
-        RIDServer::instance().free(RIDServer::BUFFER, buffer); // Free the RID of the buffer
-    }
-}
-
 void Mesh::bind(VkCommandBuffer cmd_buffer) const {
-    if (buffer == RID_INVALID) {
+    if (handle == VK_NULL_HANDLE) {
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Mesh with RID " << rid << " has no valid buffer!" << std::endl;
         #endif
         return; // If the buffer is invalid, do not bind
     }
-    
-    const Buffer &buf = BufferServer::instance().get_buffer(buffer); // Get the buffer from the server
-    uint32_t count = offsets.size();
 
     if (index_type != VK_INDEX_TYPE_MAX_ENUM) {
-        count--; // If there are indices, reduce the count by one
-        vkCmdBindIndexBuffer(cmd_buffer, buf.buffer, offsets.back(), index_type); // Bind the index buffer
+        vkCmdBindIndexBuffer(cmd_buffer, handle, index_offset, index_type); // Bind the index buffer
     }
-
-    VkBuffer *buffers = new VkBuffer[count]; // Create an array of buffers
-    for (uint32_t i = 0; i < count; ++i) {
-        buffers[i] = buf.buffer; // Fill the array with the mesh buffer
-    }
-
-    VkDeviceSize *offsets_ptr = new VkDeviceSize[count]; // Create an array for offsets
-    for (uint32_t i = 0; i < count; ++i) {
-        offsets_ptr[i] = this->offsets[i]; // Fill the offsets array
+    if (binding_count > 0) {
+        vkCmdBindVertexBuffers(cmd_buffer, 0, binding_count, vertex_buffers.data(), vertex_offsets.data()); // Bind the vertex buffers
     }
-
-    vkCmdBindVertexBuffers(cmd_buffer, 0, count, buffers, offsets_ptr); // Bind the vertex buffers
 }
 
 
@@ -61,17 +37,76 @@ MeshBuilder::~MeshBuilder() {
     }
 }
 
-RID MeshBuilder::build() const {
-    Mesh mesh;
+MeshBuilder &MeshBuilder::add_stream(const void *data, uint32_t stride, uint64_t count) {
+    if (index_type != VK_INDEX_TYPE_MAX_ENUM) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Index type already set, cannot add mesh data!" << std::endl;
+        #endif
+        return *this; // If index type is already set, return without adding data
+    }
 
-    RID rid = RIDServer::instance().new_id(RIDServer::MESH); // Generate a new RID for the mesh
-    mesh.rid = rid; // Create a new RID for the mesh
-    if (mesh.rid == RID_INVALID) {
+    if (strides.empty()) {
+        vertex_count = static_cast<uint32_t>(count);
+    } else if (vertex_count != count) {
         #ifdef ALCHEMIST_DEBUG
-        std::cerr << "Failed to create mesh RID!" << std::endl;
+        std::cerr << "Vertex stream has " << count << " elements, expected " << vertex_count << "!" << std::endl;
         #endif
-        return RID_INVALID; // Return an invalid RID if creation fails
+        return *this; // Every stream is read and uploaded for vertex_count vertices, a shorter one would be over-read
+    }
+
+    this->data = realloc(this->data, this->size + count * stride); // Allocate memory for the mesh data
+    std::memcpy((uint8_t*)this->data + this->size, data, count * stride); // Copy the data into the allocated memory
+    offsets.push_back(this->size); // Add the current size as an offset
+    strides.push_back(stride);
+    this->size += count * stride; // Set the size of the mesh data
+    return *this; // Return the builder for chaining
+}
+
+MeshBuilder &MeshBuilder::add_index_data(const void *data, VkIndexType type, uint64_t count) {
+    if (index_type == VK_INDEX_TYPE_MAX_ENUM) {
+        index_type = type;
     }
+
+    uint64_t bytes = count * MeshArena::index_size(type);
+    this->data = realloc(this->data, this->size + bytes); // Allocate memory for the mesh data
+    std::memcpy((uint8_t*)this->data + this->size, data, bytes); // Copy the indices into the allocated memory
+    offsets.push_back(this->size); // Add the current size as an offset
+    index_count = static_cast<uint32_t>(count);
+    this->size += bytes; // Set the size of the mesh data
+    return *this; // Return the builder for chaining
+}
+
+MeshBuilder &MeshBuilder::set_shared(bool shared) {
+    this->shared = shared;
+    return *this; // Return the builder for chaining
+}
+
+MeshBuilder &MeshBuilder::set_quantized(bool quantized) {
+    this->quantized = quantized;
+    return *this; // Return the builder for chaining
+}
+
+MeshBuilder &MeshBuilder::set_optimized(VkPrimitiveTopology topology) {
+    this->optimized = true;
+    this->topology = topology;
+    return *this; // Return the builder for chaining
+}
+
+RID MeshBuilder::build() const {
+    if (optimized) {
+        MeshBuilder packed(server);
+        if (optimize_into(packed)) {
+            return packed.build();
+        }
+        // Built as given otherwise
+    }
+
+    if (shared) {
+        return build_shared();
+    }
+
+    Mesh mesh;
+
     VkBufferUsageFlagBits usage = (VkBufferUsageFlagBits)(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT); // Set the usage for the buffer
     if (index_type != VK_INDEX_TYPE_MAX_ENUM) {
         usage = (VkBufferUsageFlagBits)(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |  VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT); // If indices are present, also set the index buffer usage
@@ -85,39 +120,203 @@ RID MeshBuilder::build() const {
     BufferServer::instance().upload_buffer(mesh.buffer)
         .upload_data(server.device, server.physical_device, size, data); // Upload the mesh data to the buffer
     
-    mesh.offsets = std::move(offsets); // Move the offsets into the mesh
+    mesh.handle = BufferServer::instance().get_buffer(mesh.buffer).buffer; // Resolved once, bind() never looks it up
     mesh.index_type = index_type; // Set the index type for the mesh
+
+    size_t stream_count = offsets.size();
+    if (index_type != VK_INDEX_TYPE_MAX_ENUM && stream_count > 0) {
+        stream_count--; // The last offset is the index data
+        mesh.index_offset = offsets.back();
+    }
+    if (stream_count > Mesh::MAX_BINDINGS) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Mesh has " << stream_count << " vertex streams, only " << Mesh::MAX_BINDINGS << " are bound!" << std::endl;
+        #endif
+        stream_count = Mesh::MAX_BINDINGS;
+    }
+
+    mesh.binding_count = static_cast<uint32_t>(stream_count);
+    for (uint32_t i = 0; i < mesh.binding_count; ++i) {
+        mesh.vertex_buffers[i] = mesh.handle;
+        mesh.vertex_offsets[i] = offsets[i];
+    }
+    mesh.vertex_count = vertex_count;
+    mesh.index_count = index_count;
     
-    server.meshes.emplace_back(std::move(mesh)); // Add the mesh to the server's meshes vector
+    RID rid = server.meshes.emplace(std::move(mesh)); // Add the mesh to the server's meshes
 
     #ifdef ALCHEMIST_DEBUG
-    std::cout << "Created mesh with RID: " << mesh.rid << ", buffer RID: " << mesh.buffer << std::endl;
+    std::cout << "Created mesh with RID: " << rid << ", buffer RID: " << server.meshes.get(rid)->buffer << std::endl;
     #endif
-
-    mesh.rid = RID_INVALID;
-    mesh.buffer = RID_INVALID;
     
-    return rid; // If the buffer creation fails, it will return an invalid RID
+    return rid; // Return the RID of the newly created mesh
 } // Create the mesh and return its RID
 
+bool MeshBuilder::optimize_into(MeshBuilder &out) const {
+    if (strides.empty() || vertex_count == 0) {
+        return false;
+    }
+
+    std::vector<uint32_t> indices;
+    if (index_type != VK_INDEX_TYPE_MAX_ENUM) {
+        const uint8_t *source = (const uint8_t*)data + offsets.back();
+        indices.resize(index_count);
+        for (uint32_t i = 0; i < index_count; ++i) {
+            switch (index_type) {
+                case VK_INDEX_TYPE_UINT8: indices[i] = source[i]; break;
+                case VK_INDEX_TYPE_UINT16: indices[i] = reinterpret_cast<const uint16_t*>(source)[i]; break;
+                default: indices[i] = reinterpret_cast<const uint32_t*>(source)[i]; break;
+            }
+            if (indices[i] >= vertex_count) {
+                #ifdef ALCHEMIST_DEBUG
+                std::cerr << "Index " << indices[i] << " out of range or primitive restart, mesh left unoptimized" << std::endl;
+                #endif
+                return false;
+            }
+        }
+    } else {
+        indices.resize(vertex_count);
+        for (uint32_t i = 0; i < vertex_count; ++i) {
+            indices[i] = i;
+        }
+    }
+
+    std::vector<VertexStream> streams(strides.size());
+    for (size_t i = 0; i < strides.size(); ++i) {
+        streams[i] = {(const uint8_t*)data + offsets[i], strides[i]};
+    }
+
+    deduplicate_vertices(indices, streams, vertex_count);
+    if (topology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) {
+        optimize_vertex_cache(indices, vertex_count);
+        if (position_format == VK_FORMAT_R32G32B32_SFLOAT || position_format == VK_FORMAT_R32G32B32A32_SFLOAT) {
+            optimize_overdraw(indices, streams[0], vertex_count);
+        }
+    }
+
+    std::vector<uint32_t> order;
+    uint32_t unique = optimize_vertex_fetch(indices, vertex_count, order);
+
+    out.shared = shared;
+    out.position_format = position_format;
+
+    std::vector<uint8_t> packed;
+    for (const VertexStream &stream : streams) {
+        packed.resize(static_cast<uint64_t>(unique) * stream.stride);
+        for (uint32_t vertex = 0; vertex < unique; ++vertex) {
+            std::memcpy(packed.data() + static_cast<uint64_t>(vertex) * stream.stride, stream.data + static_cast<uint64_t>(order[vertex]) * stream.stride, stream.stride);
+        }
+        out.add_stream(packed.data(), stream.stride, unique);
+    }
+
+    if (unique < UINT16_MAX) { // 0xFFFF stays free for primitive restart
+        std::vector<uint16_t> narrow(indices.begin(), indices.end());
+        out.add_index_data(narrow.data(), VK_INDEX_TYPE_UINT16, narrow.size());
+    } else {
+        out.add_index_data(indices.data(), VK_INDEX_TYPE_UINT32, indices.size());
+    }
+
+    #ifdef ALCHEMIST_DEBUG
+    std::cout << "Optimized mesh from " << vertex_count << " to " << unique << " vertices, " << indices.size() << " indices" << std::endl;
+    #endif
+
+    return true;
+}
+
+RID MeshBuilder::build_shared() const {
+    if (strides.empty() || strides.size() > Mesh::MAX_BINDINGS) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Shared mesh needs 1 to " << Mesh::MAX_BINDINGS << " vertex streams, got " << strides.size() << "!" << std::endl;
+        #endif
+        return RID_INVALID;
+    }
+
+    Mesh mesh;
+    mesh.arena = server.find_arena(strides, index_type);
+    MeshArena &arena = server.arenas[mesh.arena];
+
+    if (!arena.allocate(vertex_count, index_count, mesh.chunk, mesh.first_vertex, mesh.first_index)) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to allocate " << vertex_count << " vertices and " << index_count << " indices in the mesh arena!" << std::endl;
+        #endif
+        return RID_INVALID;
+    }
+
+    const MeshArenaChunk &chunk = arena.chunks[mesh.chunk];
+    BufferServer &buffer_server = BufferServer::instance();
+
+    // One copy per stream, the stream regions of the chunk are not contiguous
+    for (size_t i = 0; i < strides.size(); ++i) {
+        buffer_server.upload_buffer(chunk.buffer)
+            .upload_data(server.device, server.physical_device, static_cast<VkDeviceSize>(strides[i]) * vertex_count, (uint8_t*)data + offsets[i],
+                chunk.stream_offsets[i] + static_cast<VkDeviceSize>(strides[i]) * mesh.first_vertex);
+    }
+    if (index_type != VK_INDEX_TYPE_MAX_ENUM && index_count > 0) {
+        VkDeviceSize index_size = MeshArena::index_size(index_type);
+        buffer_server.upload_buffer(chunk.buffer)
+            .upload_data(server.device, server.physical_device, index_size * index_count, (uint8_t*)data + offsets.back(),
+                chunk.index_offset + index_size * mesh.first_index);
+    }
+
+    // Every mesh of the chunk binds the same buffers and offsets, the recorder drops the binds after the first
+    mesh.buffer = chunk.buffer;
+    mesh.handle = chunk.handle;
+    mesh.binding_count = static_cast<uint32_t>(strides.size());
+    for (uint32_t i = 0; i < mesh.binding_count; ++i) {
+        mesh.vertex_buffers[i] = chunk.handle;
+        mesh.vertex_offsets[i] = chunk.stream_offsets[i];
+    }
+    mesh.index_offset = chunk.index_offset;
+    mesh.index_type = index_type;
+
+    mesh.vertex_count = vertex_count;
+    mesh.index_count = index_count;
+    mesh.vertex_offset = static_cast<int32_t>(mesh.first_vertex);
+
+    RID rid = server.meshes.emplace(std::move(mesh));
+
+    #ifdef ALCHEMIST_DEBUG
+    const Mesh *created = server.meshes.get(rid);
+    std::cout << "Created shared mesh with RID: " << rid << " in arena " << created->arena << ", chunk " << created->chunk
+        << ", first vertex " << created->first_vertex << ", first index " << created->first_index << std::endl;
+    #endif
+
+    return rid;
+}
+
 
 
 MeshServer::MeshServer(VkDevice device, VkPhysicalDevice physical_device) {
     this->device = device; // Set the Vulkan device
     this->physical_device = physical_device; // Set the Vulkan physical device
-    meshes = std::vector<Mesh>(); // Initialize the meshes vector
 }
 
 MeshBuilder MeshServer::new_mesh() {
     return MeshBuilder(*this); // Return a MeshBuilder instance for creating meshes
 }
 
+void MeshServer::free_mesh(RID mesh) {
+    if (const Mesh *m = meshes.get(mesh)) {
+        if (m->arena != Mesh::STANDALONE) {
+            arenas[m->arena].release(m->chunk, m->first_vertex, m->vertex_count, m->first_index, m->index_count); // The buffer stays with the arena
+        } else if (m->buffer != RID_INVALID) {
+            BufferServer::instance().free_buffer(m->buffer);
+        }
+        meshes.erase(mesh);
+        return;
+    }
+    #ifdef ALCHEMIST_DEBUG
+    std::cerr << "Mesh with RID " << mesh << " not found for release!" << std::endl;
+    #endif
+}
+
 void MeshServer::bind_mesh(RID mesh, RID memory) {
-    for (auto &m : meshes) {
-        if (m.rid == mesh) {
-            BufferServer::instance().bind_buffer(m.buffer, memory); // Bind the mesh buffer to the specified memory
-            return; // Exit after binding
+    if (const Mesh *m = meshes.get(mesh)) {
+        if (m->arena != Mesh::STANDALONE) {
+            return; // The arena chunk was bound when it was created
         }
+        BufferServer::instance().bind_buffer(m->buffer, memory); // Bind the mesh buffer to the specified memory
+        return; // Exit after binding
     }
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Mesh with RID " << mesh << " not found for binding!" << std::endl;
@@ -125,11 +324,14 @@ void MeshServer::bind_mesh(RID mesh, RID memory) {
 }
 
 void MeshServer::get_requirements(RID mesh, VkMemoryRequirements &requirements) const {
-    for (const auto &m : meshes) {
-        if (m.rid == mesh) {
-            BufferServer::instance().get_requirements(m.buffer, requirements); // Get the memory requirements for the mesh buffer
-            return; // Exit after getting requirements
+    if (const Mesh *m = meshes.get(mesh)) {
+        if (m->arena != Mesh::STANDALONE) {
+            requirements = {}; // Nothing to bind, the arena owns its memory
+            requirements.memoryTypeBits = UINT32_MAX;
+            return;
         }
+        BufferServer::instance().get_requirements(m->buffer, requirements); // Get the memory requirements for the mesh buffer
+        return; // Exit after getting requirements
     }
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Mesh with RID " << mesh << " not found for memory requirements!" << std::endl;
@@ -137,15 +339,27 @@ void MeshServer::get_requirements(RID mesh, VkMemoryRequirements &requirements)
 }
 
 const Mesh &MeshServer::get_mesh(RID mesh) const {
-    for (const auto &m : meshes) {
-        if (m.rid == mesh) {
-            return m; // Return the mesh if found
-        }
+    if (const Mesh *m = meshes.get(mesh)) {
+        return *m; // Return the mesh if found
     }
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Mesh with RID " << mesh << " not found!" << std::endl;
     #endif
-    return *((const Mesh *)nullptr); // Return a null pointer if not found
+    return meshes.at(mesh); // Invalid mesh as a fallback
+}
+
+uint32_t MeshServer::find_arena(const std::vector<uint32_t> &strides, VkIndexType index_type) {
+    for (uint32_t i = 0; i < arenas.size(); ++i) {
+        if (arenas[i].matches(strides, index_type)) {
+            return i;
+        }
+    }
+
+    MeshArena arena;
+    arena.strides = strides;
+    arena.index_type = index_type;
+    arenas.push_back(std::move(arena)); // Chunks are added on the first allocation
+    return static_cast<uint32_t>(arenas.size() - 1);
 }
 
 MeshServer &MeshServer::instance() {
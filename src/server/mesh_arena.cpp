@@ -0,0 +1,184 @@
+
+#ifdef ALCHEMIST_DEBUG
+#include <iostream>
+#endif // ALCHEMIST_DEBUG
+
+#include <algorithm>
+#include <iterator>
+
+#include "server/mesh_arena.hpp"
+
+#include "server/buffer.hpp"
+#include "server/gpu_memory.hpp"
+#include "server/transfer.hpp"
+#include "memory/misc.hpp"
+
+void RangeList::reset(uint32_t capacity) {
+    free_ranges.clear();
+    if (capacity > 0) {
+        free_ranges.emplace(0, capacity);
+    }
+}
+
+uint32_t RangeList::take(uint32_t count) {
+    if (count == 0) {
+        return 0; // Nothing to place
+    }
+
+    for (auto it = free_ranges.begin(); it != free_ranges.end(); ++it) {
+        if (it->second < count) {
+            continue; // Doesn't fit in this range
+        }
+
+        uint32_t first = it->first;
+        uint32_t left = it->second - count;
+        free_ranges.erase(it);
+        if (left > 0) {
+            free_ranges.emplace(first + count, left); // Keep the tail
+        }
+        return first;
+    }
+    return NONE;
+}
+
+void RangeList::release(uint32_t first, uint32_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    auto next = free_ranges.lower_bound(first);
+    if (next != free_ranges.end() && first + count == next->first) {
+        count += next->second; // Merge with the following range
+        next = free_ranges.erase(next);
+    }
+    if (next != free_ranges.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == first) {
+            prev->second += count; // Merge with the preceding range
+            return;
+        }
+    }
+    free_ranges.emplace(first, count);
+}
+
+
+
+bool MeshArena::matches(const std::vector<uint32_t> &strides, VkIndexType index_type) const {
+    return this->index_type == index_type && this->strides == strides;
+}
+
+bool MeshArena::allocate(uint32_t vertex_count, uint32_t index_count, uint32_t &chunk, uint32_t &first_vertex, uint32_t &first_index) {
+    for (uint32_t attempt = 0; attempt < 2; ++attempt) {
+        for (uint32_t i = 0; i < chunks.size(); ++i) {
+            MeshArenaChunk &candidate = chunks[i];
+
+            uint32_t vertex = candidate.vertices.take(vertex_count);
+            if (vertex == RangeList::NONE) {
+                continue;
+            }
+            uint32_t index = candidate.indices.take(index_count);
+            if (index == RangeList::NONE) {
+                candidate.vertices.release(vertex, vertex_count); // Both ranges have to live in the same chunk
+                continue;
+            }
+
+            chunk = i;
+            first_vertex = vertex;
+            first_index = index;
+            return true;
+        }
+
+        if (attempt == 0 && !grow(vertex_count, index_count)) {
+            break;
+        }
+    }
+    return false;
+}
+
+void MeshArena::release(uint32_t chunk, uint32_t first_vertex, uint32_t vertex_count, uint32_t first_index, uint32_t index_count) {
+    if (chunk >= chunks.size()) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Mesh arena chunk " << chunk << " out of range!" << std::endl;
+        #endif
+        return;
+    }
+    chunks[chunk].vertices.release(first_vertex, vertex_count);
+    chunks[chunk].indices.release(first_index, index_count);
+}
+
+bool MeshArena::grow(uint32_t vertex_count, uint32_t index_count) {
+    if (strides.empty() || strides.size() > MeshArenaChunk::MAX_STREAMS) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Mesh arena layout has " << strides.size() << " streams, expected 1 to " << MeshArenaChunk::MAX_STREAMS << "!" << std::endl;
+        #endif
+        return false;
+    }
+
+    MeshArenaChunk chunk;
+    uint32_t last_vertices = chunks.empty() ? MIN_VERTICES / 2 : chunks.back().vertex_capacity;
+    uint32_t last_indices = chunks.empty() ? MIN_INDICES / 2 : chunks.back().index_capacity;
+    chunk.vertex_capacity = std::max(vertex_count, last_vertices * 2);
+    chunk.index_capacity = index_type == VK_INDEX_TYPE_MAX_ENUM ? 0 : std::max(index_count, last_indices * 2);
+
+    // Streams one after the other, each region aligned so any attribute format starts aligned
+    VkDeviceSize size = 0;
+    for (size_t i = 0; i < strides.size(); ++i) {
+        chunk.stream_offsets[i] = size;
+        size = GpuDeviceMemory<VkBuffer>::align_up(size + static_cast<VkDeviceSize>(strides[i]) * chunk.vertex_capacity, 16);
+    }
+    chunk.index_offset = size;
+    size += static_cast<VkDeviceSize>(index_size(index_type)) * chunk.index_capacity;
+
+    VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    if (index_type != VK_INDEX_TYPE_MAX_ENUM) {
+        usage |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    }
+
+    // Chunks are written again by every later upload while the graphics queue reads them, so they are shared instead of changing owner
+    TransferServer &transfer_server = TransferServer::instance();
+    BufferServer &buffer_server = BufferServer::instance();
+    chunk.buffer = buffer_server.new_buffer()
+        .set_usage(usage)
+        .set_size(size)
+        .set_queue_families({transfer_server.src_family, transfer_server.dst_family})
+        .build();
+    if (chunk.buffer == RID_INVALID) {
+        return false;
+    }
+
+    VkMemoryRequirements requirements;
+    buffer_server.get_requirements(chunk.buffer, requirements);
+
+    GpuMemoryServer &gpu_memory_server = GpuMemoryServer::instance();
+    chunk.memory = gpu_memory_server.allocate_block<VkBuffer>(
+        requirements.size,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        find_memory_type(buffer_server.physical_device, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+        FreeList // The chunk is released through its bind like any other buffer
+    );
+    if (buffer_server.bind_buffer(chunk.buffer, chunk.memory) == RID_INVALID) {
+        buffer_server.free_buffer(chunk.buffer);
+        gpu_memory_server.free_block(chunk.memory);
+        return false;
+    }
+
+    chunk.handle = buffer_server.get_buffer(chunk.buffer).buffer;
+    chunk.vertices.reset(chunk.vertex_capacity);
+    chunk.indices.reset(chunk.index_capacity);
+
+    #ifdef ALCHEMIST_DEBUG
+    std::cout << "Mesh arena grown to " << chunks.size() + 1 << " chunks, the new one holds " << chunk.vertex_capacity << " vertices and " << chunk.index_capacity << " indices" << std::endl;
+    #endif
+
+    chunks.push_back(std::move(chunk));
+    return true;
+}
+
+uint32_t MeshArena::index_size(VkIndexType type) {
+    switch (type) {
+        case VK_INDEX_TYPE_UINT8: return 1;
+        case VK_INDEX_TYPE_UINT16: return 2;
+        case VK_INDEX_TYPE_UINT32: return 4;
+        default: return 0;
+    }
+}
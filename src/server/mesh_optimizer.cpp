@@ -0,0 +1,262 @@
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#include "server/mesh_optimizer.hpp"
+
+static constexpr uint32_t NO_VERTEX = UINT32_MAX;
+
+static uint64_t hash_vertex(const std::vector<VertexStream> &streams, uint32_t vertex) {
+    uint64_t hash = 14695981039346656037ull; // FNV-1a over the bytes of the vertex in every stream
+    for (const VertexStream &stream : streams) {
+        const uint8_t *bytes = stream.data + static_cast<uint64_t>(vertex) * stream.stride;
+        for (uint32_t i = 0; i < stream.stride; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+static bool same_vertex(const std::vector<VertexStream> &streams, uint32_t a, uint32_t b) {
+    for (const VertexStream &stream : streams) {
+        if (std::memcmp(stream.data + static_cast<uint64_t>(a) * stream.stride, stream.data + static_cast<uint64_t>(b) * stream.stride, stream.stride) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void deduplicate_vertices(std::vector<uint32_t> &indices, const std::vector<VertexStream> &streams, uint32_t vertex_count) {
+    if (vertex_count == 0) {
+        return;
+    }
+
+    // Open addressing, at most half full
+    std::vector<uint32_t> table(std::bit_ceil(static_cast<uint64_t>(vertex_count) * 2), NO_VERTEX);
+    uint64_t mask = table.size() - 1;
+
+    std::vector<uint32_t> canonical(vertex_count);
+    for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+        uint64_t slot = hash_vertex(streams, vertex) & mask;
+        while (table[slot] != NO_VERTEX && !same_vertex(streams, table[slot], vertex)) {
+            slot = (slot + 1) & mask;
+        }
+        if (table[slot] == NO_VERTEX) {
+            table[slot] = vertex; // First copy
+        }
+        canonical[vertex] = table[slot];
+    }
+
+    for (uint32_t &index : indices) {
+        index = canonical[index];
+    }
+}
+
+// Triangles using each vertex, as ranges of one shared list
+struct VertexAdjacency {
+    std::vector<uint32_t> offsets; // First entry of each vertex in triangles, vertex_count + 1 entries
+    std::vector<uint32_t> triangles;
+
+    VertexAdjacency(const std::vector<uint32_t> &indices, uint32_t vertex_count) {
+        offsets.assign(vertex_count + 1, 0);
+        for (uint32_t index : indices) {
+            offsets[index + 1]++;
+        }
+        for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+            offsets[vertex + 1] += offsets[vertex];
+        }
+
+        triangles.resize(indices.size());
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (uint32_t i = 0; i < indices.size(); ++i) {
+            triangles[cursor[indices[i]]++] = i / 3;
+        }
+    }
+};
+
+void optimize_vertex_cache(std::vector<uint32_t> &indices, uint32_t vertex_count, uint32_t cache_size) {
+    uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+    if (triangle_count == 0 || indices.size() % 3 != 0) {
+        return; // Not a triangle list
+    }
+
+    VertexAdjacency adjacency(indices, vertex_count);
+
+    std::vector<uint32_t> live(vertex_count); // Triangles left to emit around each vertex
+    for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+        live[vertex] = adjacency.offsets[vertex + 1] - adjacency.offsets[vertex];
+    }
+
+    std::vector<uint32_t> cache_time(vertex_count, 0); // Time the vertex last entered the cache
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<uint32_t> dead_end; // Recently used vertices, tried when the candidates run out
+    std::vector<uint32_t> candidates;
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    uint32_t time = cache_size + 1;
+    uint32_t cursor = 0; // Next vertex in input order, the last resort
+    uint32_t fanning = 0;
+
+    while (fanning != NO_VERTEX) {
+        candidates.clear();
+
+        // Emit every triangle left around the fanning vertex
+        for (uint32_t entry = adjacency.offsets[fanning]; entry < adjacency.offsets[fanning + 1]; ++entry) {
+            uint32_t triangle = adjacency.triangles[entry];
+            if (emitted[triangle]) {
+                continue;
+            }
+            emitted[triangle] = true;
+
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                uint32_t vertex = indices[triangle * 3 + corner];
+                output.push_back(vertex);
+                dead_end.push_back(vertex);
+                candidates.push_back(vertex);
+                live[vertex]--;
+                if (time - cache_time[vertex] > cache_size) {
+                    cache_time[vertex] = time++; // Cache miss
+                }
+            }
+        }
+
+        // Next fanning vertex, the candidate still in cache after its remaining triangles are emitted and the oldest of those
+        fanning = NO_VERTEX;
+        int64_t best_priority = -1;
+        for (uint32_t vertex : candidates) {
+            if (live[vertex] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            if (time - cache_time[vertex] + 2 * live[vertex] <= cache_size) {
+                priority = time - cache_time[vertex];
+            }
+            if (priority > best_priority) {
+                best_priority = priority;
+                fanning = vertex;
+            }
+        }
+
+        // Dead end, fall back on a recent vertex then on input order
+        while (fanning == NO_VERTEX && !dead_end.empty()) {
+            uint32_t vertex = dead_end.back();
+            dead_end.pop_back();
+            if (live[vertex] > 0) {
+                fanning = vertex;
+            }
+        }
+        while (fanning == NO_VERTEX && cursor < vertex_count) {
+            if (live[cursor] > 0) {
+                fanning = cursor;
+            }
+            cursor++;
+        }
+    }
+
+    indices = std::move(output);
+}
+
+void optimize_overdraw(std::vector<uint32_t> &indices, const VertexStream &positions, uint32_t vertex_count, uint32_t cache_size) {
+    uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+    if (triangle_count == 0 || indices.size() % 3 != 0) {
+        return; // Not a triangle list
+    }
+
+    auto position = [&positions](uint32_t vertex, float out[3]) {
+        std::memcpy(out, positions.data + static_cast<uint64_t>(vertex) * positions.stride, sizeof(float) * 3);
+    };
+
+    // Clusters start at the triangles missing the FIFO cache on all three corners, splitting there costs no extra miss
+    std::vector<uint32_t> clusters;
+    std::vector<uint32_t> cache_time(vertex_count, 0);
+    uint32_t time = cache_size + 1;
+    for (uint32_t triangle = 0; triangle < triangle_count; ++triangle) {
+        uint32_t misses = 0;
+        for (uint32_t corner = 0; corner < 3; ++corner) {
+            uint32_t vertex = indices[triangle * 3 + corner];
+            if (time - cache_time[vertex] > cache_size) {
+                cache_time[vertex] = time++;
+                misses++;
+            }
+        }
+        if (misses == 3 || triangle == 0) {
+            clusters.push_back(triangle);
+        }
+    }
+    if (clusters.size() < 2) {
+        return; // Nothing to sort
+    }
+    clusters.push_back(triangle_count);
+
+    float mesh_center[3] = {0.0f, 0.0f, 0.0f};
+    for (uint32_t index : indices) {
+        float p[3];
+        position(index, p);
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            mesh_center[axis] += p[axis] / indices.size();
+        }
+    }
+
+    // Clusters facing away from the mesh center cover the others, draw them first
+    std::vector<std::pair<float, uint32_t>> order(clusters.size() - 1);
+    for (uint32_t cluster = 0; cluster + 1 < clusters.size(); ++cluster) {
+        float center[3] = {0.0f, 0.0f, 0.0f};
+        float normal[3] = {0.0f, 0.0f, 0.0f};
+        float area = 0.0f;
+
+        for (uint32_t triangle = clusters[cluster]; triangle < clusters[cluster + 1]; ++triangle) {
+            float a[3], b[3], c[3];
+            position(indices[triangle * 3 + 0], a);
+            position(indices[triangle * 3 + 1], b);
+            position(indices[triangle * 3 + 2], c);
+
+            float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+            float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+            float cross[3] = {ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0]};
+            float weight = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]); // Twice the area
+
+            for (uint32_t axis = 0; axis < 3; ++axis) {
+                center[axis] += (a[axis] + b[axis] + c[axis]) / 3.0f * weight;
+                normal[axis] += cross[axis]; // Area weighted
+            }
+            area += weight;
+        }
+
+        float score = 0.0f;
+        if (area > 0.0f) {
+            float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            for (uint32_t axis = 0; axis < 3 && length > 0.0f; ++axis) {
+                score += (center[axis] / area - mesh_center[axis]) * normal[axis] / length;
+            }
+        }
+        order[cluster] = {-score, cluster}; // Highest score first
+    }
+    std::stable_sort(order.begin(), order.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (const auto &[score, cluster] : order) {
+        output.insert(output.end(), indices.begin() + clusters[cluster] * 3, indices.begin() + clusters[cluster + 1] * 3);
+    }
+    indices = std::move(output);
+}
+
+uint32_t optimize_vertex_fetch(std::vector<uint32_t> &indices, uint32_t vertex_count, std::vector<uint32_t> &order) {
+    std::vector<uint32_t> remap(vertex_count, NO_VERTEX);
+    order.clear();
+
+    for (uint32_t &index : indices) {
+        if (remap[index] == NO_VERTEX) {
+            remap[index] = static_cast<uint32_t>(order.size());
+            order.push_back(index);
+        }
+        index = remap[index];
+    }
+    return static_cast<uint32_t>(order.size());
+}
@@ -3,13 +3,18 @@
 #include <iostream>
 #endif 
 
+#include <algorithm>
 #include <cstring>
+#include <fstream>
+#include <filesystem>
 
 #include "server/pipeline.hpp"
 #include "server/shader.hpp"
 #include "server/descriptor.hpp"
 #include "server/render_pass.hpp"
 
+#include "memory/state_key.hpp"
+
 ShaderBuilder::ShaderBuilder(VkPipelineShaderStageCreateInfo &info) : stage_info(info) {
     stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; // Initialize the structure type
     stage_info.pName = "main"; // Default entry point name, can be changed later
@@ -34,6 +39,40 @@ ShaderBuilder &ShaderBuilder::set_module(RID module) {
     return *this; // Return the current instance for method chaining
 }
 
+ShaderBuilder &ShaderBuilder::set_constant(uint32_t id, const void *value, size_t size) {
+    if (specialization == nullptr) {
+        specialization = &PipelineServer::instance().specializations.emplace_back();
+        if (const VkSpecializationInfo *previous = stage_info.pSpecializationInfo) {
+            // Keep the constants an earlier builder set on this stage
+            specialization->entries.assign(previous->pMapEntries, previous->pMapEntries + previous->mapEntryCount);
+            specialization->data.assign(static_cast<const uint8_t *>(previous->pData), static_cast<const uint8_t *>(previous->pData) + previous->dataSize);
+        }
+    }
+
+    auto entry = std::find_if(specialization->entries.begin(), specialization->entries.end(), [id](const VkSpecializationMapEntry &e) { return e.constantID == id; });
+    if (entry != specialization->entries.end() && entry->size == size) {
+        std::memcpy(specialization->data.data() + entry->offset, value, size); // Overwrite in place
+    } else {
+        if (entry != specialization->entries.end()) {
+            specialization->entries.erase(entry); // Size changed, the old bytes stay unused
+        }
+        VkSpecializationMapEntry new_entry = {};
+        new_entry.constantID = id;
+        new_entry.offset = static_cast<uint32_t>(specialization->data.size());
+        new_entry.size = size;
+        specialization->entries.push_back(new_entry);
+        specialization->data.insert(specialization->data.end(), static_cast<const uint8_t *>(value), static_cast<const uint8_t *>(value) + size);
+    }
+
+    VkSpecializationInfo &info = specialization->info;
+    info.mapEntryCount = static_cast<uint32_t>(specialization->entries.size());
+    info.pMapEntries = specialization->entries.data();
+    info.dataSize = specialization->data.size();
+    info.pData = specialization->data.data();
+    stage_info.pSpecializationInfo = &info;
+    return *this; // Return the current instance for method chaining
+}
+
 ShaderBuilder &ShaderBuilder::set_name(const char *name) {
     if (name != nullptr) {
         stage_info.pName = name; // Set the entry point name for the shader stage
@@ -72,6 +111,14 @@ VertexInput &VertexInput::add_attribute(uint32_t location, uint32_t binding, VkF
     return *this; // Return the current instance for method chaining
 }
 
+VertexInput &VertexInput::from_shader(RID shader) {
+    for (const ReflectedInput &input : ShaderServer::instance().get_shader(shader).reflection.inputs) {
+        add_binding(input.location, format_size(input.format));
+        add_attribute(input.location, input.location, input.format, 0);
+    }
+    return *this; // Return the current instance for method chaining
+}
+
 void VertexInput::build() const {
     if (bindings.empty() && attributes.empty()) {
         #ifdef ALCHEMIST_DEBUG
@@ -321,8 +368,13 @@ PipelineLayoutBuilder &PipelineLayoutBuilder::add_layout(RID layout) {
     return *this; // Return the current instance for method chaining
 }
 
+PipelineLayoutBuilder &PipelineLayoutBuilder::add_push_constant(VkShaderStageFlags stages, uint32_t offset, uint32_t size) {
+    push_constants.push_back({stages, offset, size});
+    return *this; // Return the current instance for method chaining
+}
+
 RID PipelineLayoutBuilder::build() const {
-    if (set_layouts.empty()) {
+    if (set_layouts.empty() && push_constants.empty()) {
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "No descriptor set layouts defined!" << std::endl;
         #endif
@@ -341,6 +393,8 @@ RID PipelineLayoutBuilder::build() const {
     create_info.flags = 0; // No flags
     create_info.setLayoutCount = static_cast<uint32_t>(set_layouts.size());
     create_info.pSetLayouts = set_layouts_array; // Set the descriptor set layouts
+    create_info.pushConstantRangeCount = static_cast<uint32_t>(push_constants.size());
+    create_info.pPushConstantRanges = push_constants.data();
 
     return server.new_pipeline_layout(create_info); // Create a new pipeline layout and return its RID
 }
@@ -348,13 +402,13 @@ RID PipelineLayoutBuilder::build() const {
 
 
 PipelineBuilder::PipelineBuilder(PipelineServer &server) : server(server) {
-    VkPipelineMultisampleStateCreateInfo *multisample_info = new VkPipelineMultisampleStateCreateInfo; // Allocate memory for multisample state
+    VkPipelineMultisampleStateCreateInfo *multisample_info = new VkPipelineMultisampleStateCreateInfo{}; // Allocate memory for multisample state
 
     multisample_info->sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO; // Initialize the structure type
     multisample_info->rasterizationSamples = VK_SAMPLE_COUNT_1_BIT; // Default rasterization samples is 1
     multisample_info->sampleShadingEnable = VK_FALSE;
 
-    VkPipelineViewportStateCreateInfo *viewport_state = new VkPipelineViewportStateCreateInfo;
+    VkPipelineViewportStateCreateInfo *viewport_state = new VkPipelineViewportStateCreateInfo{};
     
     viewport_state->sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewport_state->viewportCount = 1;
@@ -467,19 +521,26 @@ PipelineBuilder &PipelineBuilder::set_subpass(uint32_t subpass) {
     return *this; // Return the current instance for method chaining
 }
 
-RID PipelineBuilder::build() {
+bool PipelineBuilder::check() const {
     if (create_info.layout == VK_NULL_HANDLE) {
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Pipeline layout must be set before building!" << std::endl;
         #endif
-        return RID_INVALID; // Return an invalid RID if layout is not set
+        return false;
     }
 
     if (create_info.renderPass == VK_NULL_HANDLE) {
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Render pass must be set before building!" << std::endl;
         #endif
-        return RID_INVALID; // Return an invalid RID if render pass is not set
+        return false;
+    }
+    return true;
+}
+
+RID PipelineBuilder::build() {
+    if (!check()) {
+        return RID_INVALID; // Return an invalid RID if layout or render pass is not set
     }
 
     create_info.stageCount = static_cast<uint32_t>(stages.size());
@@ -488,6 +549,14 @@ RID PipelineBuilder::build() {
     return server.new_pipeline(create_info); // Create a new pipeline and return its RID
 }
 
+RID PipelineBuilder::build_async() {
+    if (!check()) {
+        return RID_INVALID; // Return an invalid RID if layout or render pass is not set
+    }
+
+    return server.new_pipeline_async(create_info, stages); // The stages are copied into the job
+}
+
 
 
 SimplePipelineBuilder::SimplePipelineBuilder(PipelineServer &server) : server(server) {
@@ -657,19 +726,34 @@ SimplePipelineBuilder &SimplePipelineBuilder::set_render_pass(RID render_pass) {
     return *this; // Return the current instance for method chaining
 }
 
-RID SimplePipelineBuilder::build() {
+bool SimplePipelineBuilder::check() const {
     if (create_info.layout == VK_NULL_HANDLE) {
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Pipeline layout must be set before building!" << std::endl;
         #endif
-        return RID_INVALID; // Return an invalid RID if layout is not set
+        return false;
     }
 
     if (create_info.renderPass == VK_NULL_HANDLE) {
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Render pass must be set before building!" << std::endl;
         #endif
-        return RID_INVALID; // Return an invalid RID if render pass is not set
+        return false;
+    }
+    return true;
+}
+
+RID SimplePipelineBuilder::build_async() {
+    if (!check()) {
+        return RID_INVALID; // Return an invalid RID if layout or render pass is not set
+    }
+
+    return server.new_pipeline_async(create_info, stages); // The stages are copied into the job
+}
+
+RID SimplePipelineBuilder::build() {
+    if (!check()) {
+        return RID_INVALID; // Return an invalid RID if layout or render pass is not set
     }
 
     VkPipelineShaderStageCreateInfo *stage_info = new VkPipelineShaderStageCreateInfo[stages.size()];
@@ -686,6 +770,70 @@ RID SimplePipelineBuilder::build() {
 
 
 
+ComputePipelineBuilder::ComputePipelineBuilder(PipelineServer &server) : server(server) {
+    create_info = {};
+    create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO; // Initialize the structure type
+    create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT; // The only stage of a compute pipeline
+    create_info.stage.pName = "main"; // Default entry point name, can be changed later
+    create_info.layout = VK_NULL_HANDLE; // Pipeline layout, must be set before use
+    create_info.basePipelineIndex = -1;
+}
+
+ShaderBuilder ComputePipelineBuilder::set_shader(RID module) {
+    ShaderBuilder shader_builder(create_info.stage); // Writes straight into the create info
+    shader_builder.set_stage(VK_SHADER_STAGE_COMPUTE_BIT);
+    shader_builder.set_module(module);
+    return shader_builder; // Return the shader builder for further configuration
+}
+
+ComputePipelineBuilder &ComputePipelineBuilder::set_layout(RID layout) {
+    const PipelineLayout &pipeline_layout = PipelineLayoutServer::instance().get_pipeline_layout(layout);
+    if (pipeline_layout.layout == VK_NULL_HANDLE) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Pipeline layout is not valid!" << std::endl;
+        #endif
+        return *this; // If the pipeline layout is invalid, do not set it
+    }
+    create_info.layout = pipeline_layout.layout; // Set the pipeline layout in the create info
+    return *this; // Return the current instance for method chaining
+}
+
+bool ComputePipelineBuilder::check() const {
+    if (create_info.layout == VK_NULL_HANDLE) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Pipeline layout must be set before building!" << std::endl;
+        #endif
+        return false;
+    }
+
+    if (create_info.stage.module == VK_NULL_HANDLE) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Compute shader must be set before building!" << std::endl;
+        #endif
+        return false;
+    }
+    return true;
+}
+
+RID ComputePipelineBuilder::build() const {
+    if (!check()) {
+        return RID_INVALID; // Return an invalid RID if layout or shader is not set
+    }
+
+    return server.new_compute_pipeline(create_info); // Create a new pipeline and return its RID
+}
+
+RID ComputePipelineBuilder::build_async() const {
+    if (!check()) {
+        return RID_INVALID; // Return an invalid RID if layout or shader is not set
+    }
+
+    return server.new_compute_pipeline_async(create_info);
+}
+
+
+
 PipelineLayoutServer::PipelineLayoutServer(VkDevice device) : device(device) {
     // Initialize the pipeline layout server with the Vulkan device
 }
@@ -701,24 +849,19 @@ PipelineLayoutServer::~PipelineLayoutServer() {
 }
 
 RID PipelineLayoutServer::new_pipeline_layout(const VkPipelineLayoutCreateInfo &create_info) {
-    VkPipelineLayout layout;
-    if (vkCreatePipelineLayout(device, &create_info, nullptr, &layout) != VK_SUCCESS) {
-        #ifdef ALCHEMIST_DEBUG
-        std::cerr << "Failed to create pipeline layout!" << std::endl;
-        #endif
-        return RID_INVALID; // Return an invalid RID if creation fails
+    StateKey key;
+    key.add(create_info.flags)
+        .add_array(create_info.pSetLayouts, create_info.setLayoutCount) // Set order matters, set layouts are deduplicated already
+        .add_array(create_info.pPushConstantRanges, create_info.pushConstantRangeCount);
+
+    auto it = layout_keys.find(key.bytes);
+    if (it != layout_keys.end()) {
+        if (PipelineLayout *shared = pipeline_layouts.get(it->second)) {
+            shared->references++;
+            return it->second; // Same sets and push constants, same layout
+        }
     }
 
-    PipelineLayout pl;
-    pl.layout = layout;
-    pl.rid = RIDServer::instance().new_id(RIDServer::PIPELINE_LAYOUT); // Generate a new RID for the pipeline layout
-
-    pipeline_layouts.push_back(std::move(pl)); // Add the new pipeline layout to the vector
-
-    return pipeline_layouts.back().rid; // Return the RID of the newly created pipeline layout
-}
-
-RID PipelineLayoutServer::new_pipeline_layout(VkPipelineLayoutCreateInfo &&create_info) {
     VkPipelineLayout layout;
     if (vkCreatePipelineLayout(device, &create_info, nullptr, &layout) != VK_SUCCESS) {
         #ifdef ALCHEMIST_DEBUG
@@ -727,19 +870,35 @@ RID PipelineLayoutServer::new_pipeline_layout(VkPipelineLayoutCreateInfo &&creat
         return RID_INVALID; // Return an invalid RID if creation fails
     }
 
-    PipelineLayout pl;
-    pl.layout = layout;
-    pl.rid = RIDServer::instance().new_id(RIDServer::PIPELINE_LAYOUT); // Generate a new RID for the pipeline layout
-
-    pipeline_layouts.push_back(std::move(pl)); // Add the new pipeline layout to the vector
+    RID rid = pipeline_layouts.emplace(layout); // Store the new pipeline layout
+    layout_keys[std::move(key.bytes)] = rid;
+    return rid;
+}
 
-    return pipeline_layouts.back().rid; // Return the RID of the newly created pipeline layout
+RID PipelineLayoutServer::new_pipeline_layout(VkPipelineLayoutCreateInfo &&create_info) {
+    return new_pipeline_layout(static_cast<const VkPipelineLayoutCreateInfo &>(create_info));
 }
 
 PipelineLayoutBuilder PipelineLayoutServer::new_pipeline_layout() {
     return PipelineLayoutBuilder(*this); // Create a new pipeline layout builder
 } // Create a new pipeline layout builder
 
+void PipelineLayoutServer::free_pipeline_layout(RID rid) {
+    PipelineLayout *layout = pipeline_layouts.get(rid);
+    if (layout == nullptr) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Pipeline layout with RID " << rid << " not found for release!" << std::endl;
+        #endif
+        return;
+    }
+
+    if (--layout->references > 0) {
+        return; // Still used by another build
+    }
+    vkDestroyPipelineLayout(device, layout->layout, nullptr);
+    pipeline_layouts.erase(rid); // Its key goes stale, new_pipeline_layout checks the RID is still alive
+}
+
 const PipelineLayout &PipelineLayoutServer::get_pipeline_layout(RID rid) const {
     if (rid == RID_INVALID) {
         #ifdef ALCHEMIST_DEBUG
@@ -748,10 +907,8 @@ const PipelineLayout &PipelineLayoutServer::get_pipeline_layout(RID rid) const {
         throw std::runtime_error("Invalid RID for pipeline layout"); // Throw an error if the RID is invalid
     }
 
-    for (const auto &layout : pipeline_layouts) {
-        if (layout.rid == rid) {
-            return layout; // Return the pipeline layout if found
-        }
+    if (const PipelineLayout *layout = pipeline_layouts.get(rid)) {
+        return *layout; // Return the pipeline layout if found
     }
 
     #ifdef ALCHEMIST_DEBUG
@@ -768,11 +925,32 @@ std::unique_ptr<PipelineLayoutServer> PipelineLayoutServer::__instance = nullptr
 
 
 
-PipelineServer::PipelineServer(VkDevice device) : device(device) {
-    // Initialize the pipeline server with the Vulkan device
+PipelineServer::PipelineServer(VkDevice device, VkPhysicalDevice physical_device, const char *cache_path)
+    : device(device), physical_device(physical_device), cache_path(cache_path ? cache_path : "") {
+    std::vector<uint8_t> data;
+    bool warm = load_cache(data);
+
+    VkPipelineCacheCreateInfo cache_info = {};
+    cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cache_info.initialDataSize = warm ? data.size() : 0;
+    cache_info.pInitialData = warm ? data.data() : nullptr;
+
+    if (vkCreatePipelineCache(device, &cache_info, nullptr, &cache) != VK_SUCCESS) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to create pipeline cache!" << std::endl;
+        #endif
+        cache = VK_NULL_HANDLE; // Pipelines are still created, only without a cache
+    }
+
+    #ifdef ALCHEMIST_DEBUG
+    std::cout << "Pipeline cache " << (warm ? "loaded from " : "starting cold, saving to ") << this->cache_path << std::endl;
+    #endif
 }
 
 PipelineServer::~PipelineServer() {
+    wait_all(); // Workers may still be writing to the cache and the slot map
+    save_cache();
+
     for (auto &pipeline : pipelines) {
         #ifdef ALCHEMIST_DEBUG
         std::cout << "Destroying pipeline with RID: " << pipeline.rid << std::endl;
@@ -780,43 +958,356 @@ PipelineServer::~PipelineServer() {
         vkDestroyPipeline(device, pipeline.pipeline, nullptr); // Destroy each pipeline
     }
     pipelines.clear(); // Clear the vector of pipelines
+
+    if (cache != VK_NULL_HANDLE) {
+        vkDestroyPipelineCache(device, cache, nullptr);
+    }
+}
+
+bool PipelineServer::load_cache(std::vector<uint8_t> &data) const {
+    if (cache_path.empty()) {
+        return false;
+    }
+
+    std::ifstream file(cache_path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false; // First run
+    }
+
+    size_t file_size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    data.resize(file_size);
+    file.read(reinterpret_cast<char *>(data.data()), file_size);
+    if (static_cast<size_t>(file.gcount()) != file_size || file_size < sizeof(VkPipelineCacheHeaderVersionOne)) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Pipeline cache file is truncated: " << cache_path << std::endl;
+        #endif
+        return false;
+    }
+
+    // Drivers are supposed to reject foreign blobs themselves, some crash instead
+    VkPipelineCacheHeaderVersionOne header;
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+    if (header.headerSize < sizeof(header) ||
+        header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        header.vendorID != properties.vendorID ||
+        header.deviceID != properties.deviceID ||
+        std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Pipeline cache was made by another device or driver, ignoring it" << std::endl;
+        #endif
+        return false;
+    }
+    return true;
+}
+
+bool PipelineServer::save_cache() const {
+    if (cache == VK_NULL_HANDLE || cache_path.empty()) {
+        return false;
+    }
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS || size == 0) {
+        return false;
+    }
+    std::vector<uint8_t> data(size);
+    if (vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to read the pipeline cache data!" << std::endl;
+        #endif
+        return false;
+    }
+
+    // Write next to the cache and swap it in, a crash mid-write never leaves a torn file behind
+    std::string tmp_path = cache_path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open() || !file.write(reinterpret_cast<const char *>(data.data()), size)) {
+            #ifdef ALCHEMIST_DEBUG
+            std::cerr << "Failed to write pipeline cache: " << tmp_path << std::endl;
+            #endif
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tmp_path, cache_path, error);
+    if (error) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to replace pipeline cache: " << error.message() << std::endl;
+        #endif
+        return false;
+    }
+    return true;
+}
+
+static void add_stage_key(StateKey &key, const VkPipelineShaderStageCreateInfo &stage) {
+    key.add(stage.flags).add(stage.stage).add(stage.module).add_string(stage.pName);
+    if (const VkSpecializationInfo *specialization = stage.pSpecializationInfo) {
+        key.add_array(specialization->pMapEntries, specialization->mapEntryCount)
+            .add_bytes(specialization->pData, specialization->dataSize);
+    } else {
+        key.add(0u);
+    }
+}
+
+std::string PipelineServer::pipeline_key(const VkGraphicsPipelineCreateInfo &create_info, const VkPipelineShaderStageCreateInfo *stages, uint32_t stage_count) {
+    StateKey key;
+    key.add(create_info.sType).add(create_info.flags).add(stage_count); // The structure type keeps graphics and compute keys apart
+
+    for (uint32_t i = 0; i < stage_count; ++i) {
+        add_stage_key(key, stages[i]);
+    }
+
+    // Only the fields, the builders leave padding and some pointers uninitialized
+    if (const auto *vertex_input = create_info.pVertexInputState) {
+        key.add_array(vertex_input->pVertexBindingDescriptions, vertex_input->vertexBindingDescriptionCount)
+            .add_array(vertex_input->pVertexAttributeDescriptions, vertex_input->vertexAttributeDescriptionCount);
+    } else {
+        key.add(0u);
+    }
+
+    if (const auto *input_assembly = create_info.pInputAssemblyState) {
+        key.add(input_assembly->topology).add(input_assembly->primitiveRestartEnable);
+    } else {
+        key.add(0u);
+    }
+
+    if (const auto *viewport = create_info.pViewportState) {
+        key.add_array(viewport->pViewports, viewport->viewportCount)
+            .add_array(viewport->pScissors, viewport->scissorCount);
+    } else {
+        key.add(0u);
+    }
+
+    if (const auto *rasterization = create_info.pRasterizationState) {
+        key.add(rasterization->depthClampEnable)
+            .add(rasterization->rasterizerDiscardEnable)
+            .add(rasterization->polygonMode)
+            .add(rasterization->cullMode)
+            .add(rasterization->frontFace)
+            .add(rasterization->depthBiasEnable)
+            .add(rasterization->depthBiasConstantFactor)
+            .add(rasterization->depthBiasClamp)
+            .add(rasterization->depthBiasSlopeFactor)
+            .add(rasterization->lineWidth);
+    } else {
+        key.add(0u);
+    }
+
+    if (const auto *multisample = create_info.pMultisampleState) {
+        key.add(multisample->rasterizationSamples)
+            .add(multisample->sampleShadingEnable)
+            .add(multisample->minSampleShading)
+            .add(multisample->alphaToCoverageEnable)
+            .add(multisample->alphaToOneEnable)
+            .add_array(multisample->pSampleMask, multisample->pSampleMask ? (multisample->rasterizationSamples + 31) / 32 : 0);
+    } else {
+        key.add(0u);
+    }
+
+    if (const auto *depth_stencil = create_info.pDepthStencilState) {
+        key.add(depth_stencil->depthTestEnable)
+            .add(depth_stencil->depthWriteEnable)
+            .add(depth_stencil->depthCompareOp)
+            .add(depth_stencil->depthBoundsTestEnable)
+            .add(depth_stencil->stencilTestEnable)
+            .add(depth_stencil->front)
+            .add(depth_stencil->back)
+            .add(depth_stencil->minDepthBounds)
+            .add(depth_stencil->maxDepthBounds);
+    } else {
+        key.add(0u);
+    }
+
+    if (const auto *color_blend = create_info.pColorBlendState) {
+        key.add(color_blend->logicOpEnable)
+            .add(color_blend->logicOp)
+            .add_array(color_blend->pAttachments, color_blend->attachmentCount)
+            .add(color_blend->blendConstants);
+    } else {
+        key.add(0u);
+    }
+
+    if (const auto *dynamic = create_info.pDynamicState) {
+        key.add_array(dynamic->pDynamicStates, dynamic->dynamicStateCount);
+    } else {
+        key.add(0u);
+    }
+
+    key.add(create_info.layout).add(create_info.renderPass).add(create_info.subpass);
+    return std::move(key.bytes);
+}
+
+std::string PipelineServer::compute_pipeline_key(const VkComputePipelineCreateInfo &create_info) {
+    StateKey key;
+    key.add(create_info.sType).add(create_info.flags);
+    add_stage_key(key, create_info.stage);
+    key.add(create_info.layout);
+    return std::move(key.bytes);
+}
+
+RID PipelineServer::find_pipeline(const std::string &key) const {
+    auto it = pipeline_keys.find(key);
+    if (it != pipeline_keys.end() && pipelines.contains(it->second)) {
+        return it->second;
+    }
+    return RID_INVALID;
+}
+
+RID PipelineServer::share_pipeline(const std::string &key) {
+    RID rid = find_pipeline(key);
+    if (rid != RID_INVALID) {
+        std::lock_guard<std::mutex> lock(compile_mutex);
+        pipelines.get(rid)->references++;
+    }
+    return rid;
 }
 
 RID PipelineServer::new_pipeline(const VkGraphicsPipelineCreateInfo &create_info) {
+    std::string key = pipeline_key(create_info, create_info.pStages, create_info.stageCount);
+    if (RID existing = share_pipeline(key); existing != RID_INVALID) {
+        return existing; // Same state, same pipeline
+    }
+
     VkPipeline pipeline;
 
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &create_info, nullptr, &pipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(device, cache, 1, &create_info, nullptr, &pipeline) != VK_SUCCESS) {
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Failed to create graphics pipeline!" << std::endl;
         #endif
         return RID_INVALID; // Return an invalid RID if creation fails
     }
 
-    Pipeline p;
-    p.pipeline = pipeline;
-    p.rid = RIDServer::instance().new_id(RIDServer::PIPELINE); // Generate a new RID for the pipeline
+    RID rid = pipelines.emplace(pipeline); // Store the new pipeline
+    pipeline_keys[std::move(key)] = rid;
+    return rid;
+}
 
-    pipelines.push_back(std::move(p)); // Add the new pipeline to the vector
+RID PipelineServer::new_pipeline(VkGraphicsPipelineCreateInfo &&create_info) {
+    return new_pipeline(static_cast<const VkGraphicsPipelineCreateInfo &>(create_info));
+}
+
+RID PipelineServer::new_pipeline_async(const VkGraphicsPipelineCreateInfo &create_info, std::vector<VkPipelineShaderStageCreateInfo> stages) {
+    std::string key = pipeline_key(create_info, stages.data(), static_cast<uint32_t>(stages.size()));
+    if (RID existing = share_pipeline(key); existing != RID_INVALID) {
+        return existing; // Same state, possibly still compiling
+    }
 
-    return pipelines.back().rid; // Return the RID of the newly created pipeline
+    return compile_async(std::move(key), [this, info = create_info, stages = std::move(stages)](VkPipeline &handle) mutable {
+        info.stageCount = static_cast<uint32_t>(stages.size());
+        info.pStages = stages.data();
+        return vkCreateGraphicsPipelines(device, cache, 1, &info, nullptr, &handle);
+    });
 }
 
-RID PipelineServer::new_pipeline(VkGraphicsPipelineCreateInfo &&create_info) {
+RID PipelineServer::new_compute_pipeline(const VkComputePipelineCreateInfo &create_info) {
+    std::string key = compute_pipeline_key(create_info);
+    if (RID existing = share_pipeline(key); existing != RID_INVALID) {
+        return existing; // Same state, same pipeline
+    }
+
     VkPipeline pipeline;
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &create_info, nullptr, &pipeline) != VK_SUCCESS) {
+
+    if (vkCreateComputePipelines(device, cache, 1, &create_info, nullptr, &pipeline) != VK_SUCCESS) {
         #ifdef ALCHEMIST_DEBUG
-        std::cerr << "Failed to create graphics pipeline!" << std::endl;
+        std::cerr << "Failed to create compute pipeline!" << std::endl;
         #endif
         return RID_INVALID; // Return an invalid RID if creation fails
     }
 
-    Pipeline p;
-    p.pipeline = pipeline;
-    p.rid = RIDServer::instance().new_id(RIDServer::PIPELINE); // Generate a new RID for the pipeline
+    RID rid = pipelines.emplace(pipeline); // Store the new pipeline
+    pipeline_keys[std::move(key)] = rid;
+    return rid;
+}
 
-    pipelines.push_back(std::move(p)); // Add the new pipeline to the vector
+RID PipelineServer::new_compute_pipeline_async(const VkComputePipelineCreateInfo &create_info) {
+    std::string key = compute_pipeline_key(create_info);
+    if (RID existing = share_pipeline(key); existing != RID_INVALID) {
+        return existing; // Same state, possibly still compiling
+    }
 
-    return pipelines.back().rid; // Return the RID of the newly created pipeline
+    return compile_async(std::move(key), [this, info = create_info](VkPipeline &handle) {
+        return vkCreateComputePipelines(device, cache, 1, &info, nullptr, &handle); // The stage is held by value
+    });
+}
+
+ComputePipelineBuilder PipelineServer::new_compute_pipeline() {
+    return ComputePipelineBuilder(*this);
+}
+
+RID PipelineServer::compile_async(std::string key, std::function<VkResult(VkPipeline &)> compile) {
+    Pipeline *pipeline;
+    RID rid;
+    {
+        std::lock_guard<std::mutex> lock(compile_mutex);
+        rid = pipelines.emplace(VK_NULL_HANDLE);
+        pipeline = pipelines.get(rid); // The slot map never moves its elements
+        pipeline->ready = false;
+    }
+    pipeline_keys[std::move(key)] = rid;
+
+    workers.submit([this, pipeline, compile = std::move(compile)]() {
+        VkPipeline handle = VK_NULL_HANDLE;
+        if (compile(handle) != VK_SUCCESS) {
+            #ifdef ALCHEMIST_DEBUG
+            std::cerr << "Failed to create pipeline!" << std::endl;
+            #endif
+            handle = VK_NULL_HANDLE;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(compile_mutex);
+            pipeline->pipeline = handle;
+            pipeline->ready = true;
+        }
+        compiled.notify_all();
+    });
+
+    return rid;
+}
+
+bool PipelineServer::is_ready(RID rid) {
+    std::lock_guard<std::mutex> lock(compile_mutex);
+    const Pipeline *pipeline = pipelines.get(rid);
+    return pipeline == nullptr || pipeline->ready; // Unknown RIDs have nothing to wait for
+}
+
+void PipelineServer::wait(RID rid) {
+    std::unique_lock<std::mutex> lock(compile_mutex);
+    compiled.wait(lock, [this, rid] {
+        const Pipeline *pipeline = pipelines.get(rid);
+        return pipeline == nullptr || pipeline->ready;
+    });
+}
+
+void PipelineServer::free_pipeline(RID rid) {
+    wait(rid); // A worker may still be writing the handle
+
+    std::lock_guard<std::mutex> lock(compile_mutex);
+    Pipeline *pipeline = pipelines.get(rid);
+    if (pipeline == nullptr) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Pipeline with RID " << rid << " not found for release!" << std::endl;
+        #endif
+        return;
+    }
+
+    if (--pipeline->references > 0) {
+        return; // Still used by another build
+    }
+    if (pipeline->pipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(device, pipeline->pipeline, nullptr);
+    }
+    pipelines.erase(rid); // Its key goes stale, find_pipeline checks the RID is still alive
+}
+
+void PipelineServer::wait_all() {
+    workers.wait_idle();
 }
 
 PipelineBuilder PipelineServer::new_pipeline() {
@@ -832,19 +1323,17 @@ Pipeline &PipelineServer::get_pipeline(RID rid) {
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Invalid RID for pipeline!" << std::endl;
         #endif
-        return *pipelines.end();
+        return pipelines.at(rid);
     }
 
-    for (auto &pipeline : pipelines) {
-        if (pipeline.rid == rid) {
-            return pipeline; // Return the pipeline if found
-        }
+    if (Pipeline *pipeline = pipelines.get(rid)) {
+        return *pipeline; // Return the pipeline if found
     }
 
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Pipeline with RID " << rid << " not found!" << std::endl;
     #endif
-    return *pipelines.end();
+    return pipelines.at(rid); // Invalid pipeline as a fallback
 }
 
 
@@ -853,19 +1342,17 @@ const Pipeline &PipelineServer::get_pipeline(RID rid) const {
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Invalid RID for pipeline!" << std::endl;
         #endif
-        return *pipelines.cend();
+        return pipelines.at(rid);
     }
 
-    for (const auto &pipeline : pipelines) {
-        if (pipeline.rid == rid) {
-            return pipeline; // Return the pipeline if found
-        }
+    if (const Pipeline *pipeline = pipelines.get(rid)) {
+        return *pipeline; // Return the pipeline if found
     }
 
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Pipeline with RID " << rid << " not found!" << std::endl;
     #endif
-    return *pipelines.cend();
+    return pipelines.at(rid); // Invalid pipeline as a fallback
 }
 
 PipelineServer &PipelineServer::instance() {
@@ -8,29 +8,8 @@
 
 #include "vulkan/command_buffer.hpp"
 
-Submit::Submit(VkQueue queue) : queue(queue) {}
-
-Submit::Submit(Submit &&other)
-    : queue(other.queue) {
-    command_buffers = std::move(other.command_buffers); // Move command buffers from the other Submit
-    wait_semaphores = std::move(other.wait_semaphores); // Move wait semaphores from the other Submit
-    signal_semaphores = std::move(other.signal_semaphores); // Move signal semaphores from the other Submit
-}
-
-Submit::~Submit() {}
-
-void Submit::wait() const {
-    // Wait for the queue to finish processing the submitted command buffers
-    if (vkQueueWaitIdle(queue) != VK_SUCCESS) {
-        #ifdef ALCHEMIST_DEBUG
-        std::cerr << "Failed to wait for queue!" << std::endl;
-        #endif
-    }
-}
-
-
-
-SubmitBuilder::SubmitBuilder(VkQueue queue) : queue(queue) {}
+SubmitBuilder::SubmitBuilder(VkQueue queue, VkDevice device, VkSemaphore timeline, uint64_t *timeline_value)
+    : queue(queue), device(device), timeline(timeline), timeline_value(timeline_value) {}
 
 SubmitBuilder &SubmitBuilder::add_command_buffer(const CommandBuffer &buffer) {
     command_buffers.push_back(buffer.buffer); // Add the Vulkan command buffer handle to the vector
@@ -40,17 +19,44 @@ SubmitBuilder &SubmitBuilder::add_command_buffer(const CommandBuffer &buffer) {
 SubmitBuilder &SubmitBuilder::add_wait_semaphore(VkSemaphore semaphore, VkPipelineStageFlags stage) {
     wait_semaphores.push_back(semaphore); // Add the Vulkan semaphore handle to
     wait_stages.push_back(stage); // Add the corresponding pipeline stage flag to the vector
+    wait_values.push_back(0); // Binary semaphore, the value is ignored
+    return *this; // Return the builder for method chaining
+}
+
+SubmitBuilder &SubmitBuilder::add_wait(const GpuFuture &future, VkPipelineStageFlags stage) {
+    if (!future.valid()) {
+        return *this; // Nothing to wait for
+    }
+    wait_semaphores.push_back(future.semaphore);
+    wait_stages.push_back(stage);
+    wait_values.push_back(future.value); // Wait until the timeline reaches the submission
     return *this; // Return the builder for method chaining
 }
 
 SubmitBuilder &SubmitBuilder::add_signal_semaphore(VkSemaphore semaphore) {
     signal_semaphores.push_back(semaphore); // Add the Vulkan semaphore handle to
+    signal_values.push_back(0); // Binary semaphore, the value is ignored
     return *this; // Return the builder for method chaining
 }
 
-Submit SubmitBuilder::submit(VkFence fence) {
+GpuFuture SubmitBuilder::submit(VkFence fence) {
+    GpuFuture future;
+    if (timeline != VK_NULL_HANDLE) {
+        future = {device, timeline, *timeline_value + 1};
+        signal_semaphores.push_back(timeline); // Every submission bumps the queue timeline
+        signal_values.push_back(future.value);
+    }
+
+    VkTimelineSemaphoreSubmitInfo timeline_info = {};
+    timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_info.waitSemaphoreValueCount = static_cast<uint32_t>(wait_values.size());
+    timeline_info.pWaitSemaphoreValues = wait_values.data();
+    timeline_info.signalSemaphoreValueCount = static_cast<uint32_t>(signal_values.size());
+    timeline_info.pSignalSemaphoreValues = signal_values.data();
+
     VkSubmitInfo submit_info = {};
     submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.pNext = &timeline_info;
     submit_info.commandBufferCount = static_cast<uint32_t>(command_buffers.size());
     submit_info.pCommandBuffers = command_buffers.data(); // Pointer to the command buffers
 
@@ -65,35 +71,44 @@ Submit SubmitBuilder::submit(VkFence fence) {
         submit_info.pSignalSemaphores = signal_semaphores.data(); // Pointer to the signal semaphores
     }
 
-    Submit submit(queue); // Create a Submit object with the queue and command buffers
-    submit.command_buffers.swap(command_buffers); // Transfer ownership of command buffers to the Submit object
-    submit.wait_semaphores.swap(wait_semaphores); // Transfer ownership of wait semap
-    submit.signal_semaphores.swap(signal_semaphores); // Transfer ownership of signal semaphores
-    submit.wait_stages.swap(wait_stages); // Transfer ownership of wait stages
-
     // Submit the command buffers to the queue
     if (vkQueueSubmit(queue, 1, &submit_info, fence) != VK_SUCCESS) {
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Failed to submit command buffer!" << std::endl;
         #endif
-        return Submit(queue); // Return an empty Submit on failure
+        return {}; // Return an empty future on failure
+    }
+
+    if (timeline != VK_NULL_HANDLE) {
+        *timeline_value = future.value; // The submission is in, later ones signal higher values
     }
 
-    return submit; // Return the Submit object
+    return future;
 }
 
 
 
 SubmitBuilder Queue::submit() const {
-    return SubmitBuilder(queue); // Return a SubmitBuilder initialized with the queue
+    return SubmitBuilder(queue, device, timeline, &timeline_value); // Return a SubmitBuilder initialized with the queue
+}
+
+GpuFuture Queue::last() const {
+    if (timeline == VK_NULL_HANDLE || timeline_value == 0) {
+        return {}; // Nothing submitted yet
+    }
+    return {device, timeline, timeline_value};
 }
 
 void Queue::wait() const {
-    if (vkQueueWaitIdle(queue) != VK_SUCCESS) {
-        #ifdef ALCHEMIST_DEBUG
-        std::cerr << "Failed to wait for queue!" << std::endl;
-        #endif
+    if (timeline == VK_NULL_HANDLE) {
+        if (vkQueueWaitIdle(queue) != VK_SUCCESS) {
+            #ifdef ALCHEMIST_DEBUG
+            std::cerr << "Failed to wait for queue!" << std::endl;
+            #endif
+        }
+        return;
     }
+    last().wait(); // Only this queue's submissions, other users of the VkQueue keep running
 }
 
 
@@ -101,33 +116,46 @@ void Queue::wait() const {
 QueueServer::QueueServer(VkDevice device) : device(device) {}
 
 QueueServer::~QueueServer() {
-    #ifdef ALCHEMIST_DEBUG
     for (const auto &queue : queues) {
+        #ifdef ALCHEMIST_DEBUG
         std::cout << "Destroying queue with RID: " << queue.rid << std::endl;
+        #endif
+        if (queue.timeline != VK_NULL_HANDLE) {
+            vkDestroySemaphore(device, queue.timeline, nullptr); // Destroy the queue timeline
+        }
     }
-    #endif
 }
 
 RID QueueServer::new_queue(uint32_t queue_family_index, uint32_t queue_index) {
     VkQueue queue;
-    RID rid = RIDServer::instance().new_id(RIDServer::QUEUE); // Get a new RID for the queue
 
     vkGetDeviceQueue(device, queue_family_index, queue_index, &queue);
 
+    VkSemaphoreTypeCreateInfo type_info = {};
+    type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    type_info.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphore_info = {};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphore_info.pNext = &type_info;
+
     Queue new_queue;
     new_queue.queue = queue;
-    new_queue.rid = rid; // Set the RID for the new queue
-
-    queues.emplace_back(std::move(new_queue)); // Add the new queue to the queues vector
+    new_queue.device = device;
+    if (vkCreateSemaphore(device, &semaphore_info, nullptr, &new_queue.timeline) != VK_SUCCESS) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to create queue timeline semaphore!" << std::endl;
+        #endif
+        new_queue.timeline = VK_NULL_HANDLE; // Submissions still work, without futures
+    }
 
-    return rid; // Return the RID of the newly created queue
+    return queues.emplace(std::move(new_queue)); // Add the new queue and return its RID
 }
 
 SubmitBuilder QueueServer::submit(RID rid) const {
-    for (const auto &queue : queues) {
-        if (queue.rid == rid) {
-            return queue.submit(); // Return a SubmitBuilder for the specified queue
-        }
+    if (const Queue *queue = queues.get(rid)) {
+        return queue->submit(); // Return a SubmitBuilder for the specified queue
     }
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Queue with RID " << rid << " not found!" << std::endl;
@@ -136,10 +164,8 @@ SubmitBuilder QueueServer::submit(RID rid) const {
 }
 
 const Queue &QueueServer::get_queue(RID rid) const {
-    for (const auto &queue : queues) {
-        if (queue.rid == rid) {
-            return queue; // Return the queue with the specified RID
-        }
+    if (const Queue *queue = queues.get(rid)) {
+        return *queue; // Return the queue with the specified RID
     }
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Queue with RID " << rid << " not found!" << std::endl;
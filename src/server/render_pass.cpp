@@ -73,7 +73,7 @@ RenderPassBegin &RenderPassBegin::add_clear_depth(float value) {
     return *this;
 }
 
-void RenderPassBegin::begin() {
+void RenderPassBegin::begin(VkSubpassContents contents) {
     if (begin_info.renderPass == VK_NULL_HANDLE || begin_info.framebuffer == VK_NULL_HANDLE) {
         #ifdef ALCHEMIST_DEBUG
         std::cerr << "Render pass or framebuffer not set before beginning render pass!" << std::endl;
@@ -84,7 +84,7 @@ void RenderPassBegin::begin() {
     begin_info.pClearValues = clear_values.data();
     begin_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
 
-    vkCmdBeginRenderPass(cmd_buffer, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(cmd_buffer, &begin_info, contents);
 }
 
 void RenderPassBegin::end() {
@@ -324,11 +324,8 @@ RID RenderPassServer::new_render_pass(const VkRenderPassCreateInfo &create_info)
 
     RenderPass rp;
     rp.render_pass = render_pass;
-    rp.rid = RIDServer::instance().new_id(RIDServer::RENDER_PASS);
     
-    render_passes.push_back(std::move(rp));
-    
-    return render_passes.back().rid;
+    return render_passes.emplace(std::move(rp));
 }
 
 RID RenderPassServer::new_render_pass(VkRenderPassCreateInfo &&create_info) {
@@ -342,11 +339,8 @@ RID RenderPassServer::new_render_pass(VkRenderPassCreateInfo &&create_info) {
 
     RenderPass rp;
     rp.render_pass = render_pass;
-    rp.rid = RIDServer::instance().new_id(RIDServer::RENDER_PASS);
-    
-    render_passes.push_back(std::move(rp));
     
-    return render_passes.back().rid;
+    return render_passes.emplace(std::move(rp));
 }
 
 RenderingPassBuilder RenderPassServer::new_render_pass() {
@@ -369,16 +363,14 @@ const RenderPass &RenderPassServer::get_render_pass(RID rid) const {
         throw std::runtime_error("Invalid RID provided for render pass retrieval.");
     }
 
-    for (const auto &render_pass : render_passes) {
-        if (render_pass.rid == rid) {
-            return render_pass; // Return the found render pass
-        }
+    if (const RenderPass *render_pass = render_passes.get(rid)) {
+        return *render_pass; // Return the found render pass
     }
 
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Render pass with RID " << rid << " not found!" << std::endl;
     #endif
-    return render_passes.back(); // Return the last render pass as a fallback (could be invalid)
+    return render_passes.at(rid); // Invalid render pass as a fallback
 }
 
 RenderPassServer &RenderPassServer::instance() {
@@ -4,11 +4,224 @@
 #endif // ALCHEMIST_DEBUG
 
 #include <fstream>
+#include <cstring>
+#include <string>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // _WIN32
 
 #include "server/shader.hpp"
+#include "server/descriptor.hpp"
+#include "server/pipeline.hpp"
+
+// Must match fnv1a_64 in pack_shaders.py
+static uint64_t shader_name_hash(const char *name) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const char *c = name; *c; ++c) {
+        hash ^= static_cast<uint8_t>(*c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+bool ShaderArchive::open(const char *file_path) {
+    close();
+
+    #ifndef _WIN32
+    int fd = ::open(file_path, O_RDONLY);
+    if (fd < 0) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to open shader archive: " << file_path << std::endl;
+        #endif
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            data = static_cast<const uint8_t *>(mapping);
+            size = st.st_size;
+        }
+    }
+    ::close(fd); // The mapping keeps the file alive
+    #endif // _WIN32
+
+    if (data == nullptr) {
+        // No mmap on this platform or the mapping failed, read the archive into memory instead
+        std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            #ifdef ALCHEMIST_DEBUG
+            std::cerr << "Failed to open shader archive: " << file_path << std::endl;
+            #endif
+            return false;
+        }
+        fallback.resize(file.tellg());
+        file.seekg(0, std::ios::beg);
+        file.read(reinterpret_cast<char *>(fallback.data()), fallback.size());
+        data = fallback.data();
+        size = fallback.size();
+    }
+
+    uint32_t header[4] = {};
+    if (size >= sizeof(header)) {
+        std::memcpy(header, data, sizeof(header));
+    }
+    if (header[0] != MAGIC || header[1] != VERSION || sizeof(header) + header[2] * sizeof(ShaderArchiveEntry) > size) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Invalid shader archive: " << file_path << std::endl;
+        #endif
+        close();
+        return false;
+    }
+
+    entries = reinterpret_cast<const ShaderArchiveEntry *>(data + sizeof(header));
+    entry_count = header[2];
+
+    #ifdef ALCHEMIST_DEBUG
+    std::cout << "Opened shader archive " << file_path << " with " << entry_count << " shaders" << std::endl;
+    #endif
+    return true;
+}
+
+void ShaderArchive::close() {
+    #ifndef _WIN32
+    if (data != nullptr && fallback.empty()) {
+        munmap(const_cast<uint8_t *>(data), size);
+    }
+    #endif // _WIN32
+    fallback.clear();
+    data = nullptr;
+    size = 0;
+    entries = nullptr;
+    entry_count = 0;
+}
+
+const ShaderArchiveEntry *ShaderArchive::find(const char *name) const {
+    uint64_t hash = shader_name_hash(name);
+    const ShaderArchiveEntry *end = entries + entry_count;
+    const ShaderArchiveEntry *entry = std::lower_bound(entries, end, hash, [](const ShaderArchiveEntry &entry, uint64_t hash) {
+        return entry.name_hash < hash;
+    });
+
+    if (entry == end || entry->name_hash != hash || entry->offset + entry->size > size) {
+        return nullptr;
+    }
+    return entry;
+}
+
+ShaderLayoutBuilder::ShaderLayoutBuilder(ShaderServer &server) : server(server) {}
+
+ShaderLayoutBuilder &ShaderLayoutBuilder::add_shader(RID shader) {
+    const ShaderReflection &reflection = server.get_shader(shader).reflection;
+
+    for (const ReflectedBinding &binding : reflection.bindings) {
+        auto it = std::lower_bound(bindings.begin(), bindings.end(), binding, [](const ReflectedBinding &a, const ReflectedBinding &b) {
+            return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+        });
+
+        if (it == bindings.end() || it->set != binding.set || it->binding != binding.binding) {
+            bindings.insert(it, binding); // Kept sorted, the layouts come out canonical whatever the shader order
+            continue;
+        }
+
+        if (it->type != binding.type || it->count != binding.count) {
+            #ifdef ALCHEMIST_DEBUG
+            std::cerr << "Shaders disagree on set " << binding.set << " binding " << binding.binding << std::endl;
+            #endif
+            continue; // Keep the first declaration
+        }
+        it->stages |= binding.stages;
+    }
+
+    if (reflection.push_constant.size > 0) {
+        auto it = std::find_if(push_constants.begin(), push_constants.end(), [&](const VkPushConstantRange &range) {
+            return range.stageFlags == reflection.push_constant.stageFlags;
+        });
+        if (it == push_constants.end()) {
+            push_constants.push_back(reflection.push_constant);
+        }
+        std::sort(push_constants.begin(), push_constants.end(), [](const VkPushConstantRange &a, const VkPushConstantRange &b) {
+            return a.stageFlags < b.stageFlags;
+        });
+    }
+
+    return *this; // Return the current instance for method chaining
+}
+
+ShaderLayoutBuilder &ShaderLayoutBuilder::set_dynamic(uint32_t set, uint32_t binding) {
+    for (ReflectedBinding &reflected : bindings) {
+        if (reflected.set != set || reflected.binding != binding) {
+            continue;
+        }
+        if (reflected.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+            reflected.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        } else if (reflected.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
+            reflected.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        }
+        return *this;
+    }
+
+    #ifdef ALCHEMIST_DEBUG
+    std::cerr << "No buffer at set " << set << " binding " << binding << " to make dynamic" << std::endl;
+    #endif
+    return *this;
+}
+
+ShaderLayout ShaderLayoutBuilder::build() const {
+    ShaderLayout layout;
+
+    uint32_t set_count = bindings.empty() ? 0 : bindings.back().set + 1;
+    auto pipeline_builder = PipelineLayoutServer::instance().new_pipeline_layout();
+
+    auto it = bindings.begin();
+    for (uint32_t set = 0; set < set_count; ++set) {
+        std::vector<VkDescriptorSetLayoutBinding> set_bindings;
+        for (; it != bindings.end() && it->set == set; ++it) {
+            VkDescriptorSetLayoutBinding binding{};
+            binding.binding = it->binding;
+            binding.descriptorType = it->type;
+            binding.descriptorCount = it->count;
+            binding.stageFlags = it->stages;
+            set_bindings.push_back(binding);
+        }
+
+        VkDescriptorSetLayoutCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        create_info.bindingCount = static_cast<uint32_t>(set_bindings.size());
+        create_info.pBindings = set_bindings.data(); // Unused sets in between get an empty layout
+
+        RID set_layout = DescriptorLayoutServer::instance().new_descriptor_layout(create_info); // Deduplicated by content
+        if (set_layout == RID_INVALID) {
+            return {};
+        }
+        layout.set_layouts.push_back(set_layout);
+        pipeline_builder.add_layout(set_layout);
+    }
+
+    for (const VkPushConstantRange &range : push_constants) {
+        pipeline_builder.add_push_constant(range.stageFlags, range.offset, range.size);
+    }
+
+    if (set_count == 0 && push_constants.empty()) {
+        VkPipelineLayoutCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layout.pipeline_layout = PipelineLayoutServer::instance().new_pipeline_layout(create_info); // Shaders without any resource
+        return layout;
+    }
+
+    layout.pipeline_layout = pipeline_builder.build(); // Deduplicated by content
+    return layout;
+}
 
 ShaderServer::ShaderServer(VkDevice device) : device(device) {}
 ShaderServer::~ShaderServer() {
+    archive.close();
     for (auto &shader : shaders) {
         #ifdef ALCHEMIST_DEBUG
         std::cout << "Destroying shader with RID: " << shader.rid << std::endl;
@@ -19,7 +232,6 @@ ShaderServer::~ShaderServer() {
 
 RID ShaderServer::new_shader(const VkShaderModuleCreateInfo &create_info) {
     VkShaderModule shader_module;
-    RID rid = RIDServer::instance().new_id(RIDServer::SHADER);
 
     if (vkCreateShaderModule(device, &create_info, nullptr, &shader_module) != VK_SUCCESS) {
     #ifdef ALCHEMIST_DEBUG
@@ -30,16 +242,13 @@ RID ShaderServer::new_shader(const VkShaderModuleCreateInfo &create_info) {
 
     Shader shader;
     shader.shader_module = shader_module;
-    shader.rid = rid;
-
-    shaders.emplace_back(std::move(shader)); // Add the created shader to the server's shaders vector
+    shader.reflection.reflect(create_info.pCode, create_info.codeSize); // Layouts and vertex inputs are derived from it
 
-    return rid; // Return the RID of the newly created shader
+    return shaders.emplace(std::move(shader)); // Add the created shader to the server's shaders and return its RID
 }
 
 RID ShaderServer::new_shader(VkShaderModuleCreateInfo &&create_info) {
     VkShaderModule shader_module;
-    RID rid = RIDServer::instance().new_id(RIDServer::SHADER);
 
     if (vkCreateShaderModule(device, &create_info, nullptr, &shader_module) != VK_SUCCESS) {
     #ifdef ALCHEMIST_DEBUG
@@ -50,11 +259,9 @@ RID ShaderServer::new_shader(VkShaderModuleCreateInfo &&create_info) {
 
     Shader shader;
     shader.shader_module = shader_module;
-    shader.rid = rid;
+    shader.reflection.reflect(create_info.pCode, create_info.codeSize); // Layouts and vertex inputs are derived from it
 
-    shaders.emplace_back(std::move(shader)); // Add the created shader to the server's shaders vector
-
-    return rid; // Return the RID of the newly created shader
+    return shaders.emplace(std::move(shader)); // Add the created shader to the server's shaders and return its RID
 }
 
 RID ShaderServer::from_file(const char *file_path) {
@@ -98,11 +305,41 @@ RID ShaderServer::from_file(const char *file_path) {
     return rid; // Return the RID of the newly created shader
 }
 
+bool ShaderServer::open_archive(const char *file_path, const char *loose_directory) {
+    this->loose_directory = loose_directory; // Set first, the loose files are the fallback when the archive can't be opened
+    return archive.open(file_path);
+}
+
+RID ShaderServer::from_archive(const char *name) {
+    const ShaderArchiveEntry *entry = archive.entries ? archive.find(name) : nullptr;
+    if (entry == nullptr) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Shader " << name << " not in archive, loading the loose file" << std::endl;
+        #endif
+        return from_file((loose_directory + name).c_str());
+    }
+
+    VkShaderModuleCreateInfo create_info{};
+    create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    create_info.codeSize = entry->size;
+    create_info.pCode = reinterpret_cast<const uint32_t *>(archive.data + entry->offset); // Blobs are 16 byte aligned, no copy
+    RID rid = new_shader(create_info);
+
+    #ifdef ALCHEMIST_DEBUG
+    if (rid != RID_INVALID) {
+        std::cout << "Shader created from archive: " << name << " with RID: " << rid << std::endl;
+    }
+    #endif
+    return rid;
+}
+
+ShaderLayoutBuilder ShaderServer::new_layout() {
+    return ShaderLayoutBuilder(*this); // Create a new layout builder
+}
+
 const Shader &ShaderServer::get_shader(RID rid) const {
-    for (const auto &shader : shaders) {
-        if (shader.rid == rid) {
-            return shader; // Return the shader if the RID matches
-        }
+    if (const Shader *shader = shaders.get(rid)) {
+        return *shader; // Return the shader if the RID matches
     }
     #ifdef ALCHEMIST_DEBUG
     std::cerr << "Shader with RID: " << rid << " not found!" << std::endl;
@@ -0,0 +1,409 @@
+
+#ifdef ALCHEMIST_DEBUG
+#include <iostream>
+#endif // ALCHEMIST_DEBUG
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include "server/shader_reflection.hpp"
+
+// Subset of the SPIR-V grammar the reflection needs, values from the SPIR-V specification
+namespace spv {
+    constexpr uint32_t MAGIC = 0x07230203;
+
+    constexpr uint32_t OP_ENTRY_POINT = 15;
+    constexpr uint32_t OP_TYPE_BOOL = 20;
+    constexpr uint32_t OP_TYPE_INT = 21;
+    constexpr uint32_t OP_TYPE_FLOAT = 22;
+    constexpr uint32_t OP_TYPE_VECTOR = 23;
+    constexpr uint32_t OP_TYPE_MATRIX = 24;
+    constexpr uint32_t OP_TYPE_IMAGE = 25;
+    constexpr uint32_t OP_TYPE_SAMPLER = 26;
+    constexpr uint32_t OP_TYPE_SAMPLED_IMAGE = 27;
+    constexpr uint32_t OP_TYPE_ARRAY = 28;
+    constexpr uint32_t OP_TYPE_RUNTIME_ARRAY = 29;
+    constexpr uint32_t OP_TYPE_STRUCT = 30;
+    constexpr uint32_t OP_TYPE_POINTER = 32;
+    constexpr uint32_t OP_CONSTANT = 43;
+    constexpr uint32_t OP_VARIABLE = 59;
+    constexpr uint32_t OP_DECORATE = 71;
+    constexpr uint32_t OP_MEMBER_DECORATE = 72;
+
+    constexpr uint32_t DECORATION_BUFFER_BLOCK = 3;
+    constexpr uint32_t DECORATION_ARRAY_STRIDE = 6;
+    constexpr uint32_t DECORATION_MATRIX_STRIDE = 7;
+    constexpr uint32_t DECORATION_BUILT_IN = 11;
+    constexpr uint32_t DECORATION_LOCATION = 30;
+    constexpr uint32_t DECORATION_BINDING = 33;
+    constexpr uint32_t DECORATION_DESCRIPTOR_SET = 34;
+    constexpr uint32_t DECORATION_OFFSET = 35;
+
+    constexpr uint32_t STORAGE_UNIFORM_CONSTANT = 0;
+    constexpr uint32_t STORAGE_INPUT = 1;
+    constexpr uint32_t STORAGE_UNIFORM = 2;
+    constexpr uint32_t STORAGE_PUSH_CONSTANT = 9;
+    constexpr uint32_t STORAGE_STORAGE_BUFFER = 12;
+
+    constexpr uint32_t DIM_BUFFER = 5;
+    constexpr uint32_t DIM_SUBPASS_DATA = 6;
+}
+
+namespace {
+
+struct Decorations {
+    uint32_t set = 0;
+    uint32_t binding = 0;
+    uint32_t location = 0;
+    uint32_t array_stride = 0;
+    bool has_binding = false;
+    bool has_location = false;
+    bool buffer_block = false;
+    bool built_in = false;
+};
+
+// Ids of the module, indexed by result id
+struct Module {
+    std::vector<const uint32_t *> definitions; // Instruction defining each id, nullptr if not a type, constant or variable
+    std::vector<Decorations> decorations;
+    std::unordered_map<uint64_t, uint32_t> member_offsets; // (struct id << 32 | member) -> Offset
+    std::unordered_map<uint64_t, uint32_t> member_matrix_strides; // (struct id << 32 | member) -> MatrixStride
+
+    const uint32_t *definition(uint32_t id) const {
+        return id < definitions.size() ? definitions[id] : nullptr;
+    }
+
+    uint32_t opcode(uint32_t id) const {
+        const uint32_t *op = definition(id);
+        return op ? (op[0] & 0xFFFF) : 0;
+    }
+
+    uint32_t constant(uint32_t id) const {
+        const uint32_t *op = definition(id);
+        return op && (op[0] & 0xFFFF) == spv::OP_CONSTANT ? op[3] : 1;
+    }
+
+    // Size in bytes of a type laid out with explicit offsets and strides
+    uint32_t size_of(uint32_t id, uint32_t matrix_stride = 0) const {
+        const uint32_t *op = definition(id);
+        if (op == nullptr) {
+            return 0;
+        }
+
+        switch (op[0] & 0xFFFF) {
+            case spv::OP_TYPE_BOOL:
+                return 4;
+            case spv::OP_TYPE_INT:
+            case spv::OP_TYPE_FLOAT:
+                return op[2] / 8;
+            case spv::OP_TYPE_VECTOR:
+                return size_of(op[2]) * op[3];
+            case spv::OP_TYPE_MATRIX:
+                return (matrix_stride ? matrix_stride : size_of(op[2])) * op[3];
+            case spv::OP_TYPE_ARRAY: {
+                uint32_t stride = decorations[id].array_stride;
+                return (stride ? stride : size_of(op[2], matrix_stride)) * constant(op[3]);
+            }
+            case spv::OP_TYPE_STRUCT: {
+                uint32_t size = 0;
+                uint32_t member_count = (op[0] >> 16) - 2;
+                for (uint32_t i = 0; i < member_count; ++i) {
+                    uint64_t key = (static_cast<uint64_t>(id) << 32) | i;
+                    auto offset = member_offsets.find(key);
+                    auto stride = member_matrix_strides.find(key);
+                    uint32_t member_size = size_of(op[2 + i], stride != member_matrix_strides.end() ? stride->second : 0);
+                    size = std::max(size, (offset != member_offsets.end() ? offset->second : 0) + member_size);
+                }
+                return size;
+            }
+            default:
+                return 0; // Runtime arrays and opaque types have no static size
+        }
+    }
+
+    // Lowest member offset of a block, push constant ranges start there
+    uint32_t first_offset(uint32_t id) const {
+        const uint32_t *op = definition(id);
+        if (op == nullptr || (op[0] & 0xFFFF) != spv::OP_TYPE_STRUCT) {
+            return 0;
+        }
+
+        uint32_t offset = UINT32_MAX;
+        uint32_t member_count = (op[0] >> 16) - 2;
+        for (uint32_t i = 0; i < member_count; ++i) {
+            auto it = member_offsets.find((static_cast<uint64_t>(id) << 32) | i);
+            offset = std::min(offset, it != member_offsets.end() ? it->second : 0);
+        }
+        return offset == UINT32_MAX ? 0 : offset;
+    }
+
+    VkDescriptorType descriptor_type(uint32_t id, uint32_t storage) const {
+        const uint32_t *op = definition(id);
+        if (op == nullptr) {
+            return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+        }
+
+        switch (op[0] & 0xFFFF) {
+            case spv::OP_TYPE_STRUCT:
+                if (storage == spv::STORAGE_STORAGE_BUFFER || decorations[id].buffer_block) {
+                    return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                }
+                return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            case spv::OP_TYPE_SAMPLER:
+                return VK_DESCRIPTOR_TYPE_SAMPLER;
+            case spv::OP_TYPE_SAMPLED_IMAGE: {
+                const uint32_t *image = definition(op[2]);
+                if (image && image[3] == spv::DIM_BUFFER) {
+                    return VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                }
+                return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            }
+            case spv::OP_TYPE_IMAGE:
+                if (op[3] == spv::DIM_SUBPASS_DATA) {
+                    return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                }
+                if (op[3] == spv::DIM_BUFFER) {
+                    return op[7] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                }
+                return op[7] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE; // Sampled 2 means read/write
+            default:
+                return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+        }
+    }
+
+    VkFormat input_format(uint32_t id) const {
+        const uint32_t *op = definition(id);
+        if (op == nullptr) {
+            return VK_FORMAT_UNDEFINED;
+        }
+
+        uint32_t components = 1;
+        if ((op[0] & 0xFFFF) == spv::OP_TYPE_VECTOR) {
+            components = op[3];
+            op = definition(op[2]);
+        }
+        uint32_t opcode = op ? (op[0] & 0xFFFF) : 0;
+        if ((opcode != spv::OP_TYPE_FLOAT && opcode != spv::OP_TYPE_INT) || op[2] != 32 || components > 4) {
+            return VK_FORMAT_UNDEFINED; // Only 32 bit components are reflected
+        }
+
+        static constexpr VkFormat FLOAT_FORMATS[] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+        static constexpr VkFormat SINT_FORMATS[] = {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT};
+        static constexpr VkFormat UINT_FORMATS[] = {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+
+        switch (opcode) {
+            case spv::OP_TYPE_FLOAT:
+                return FLOAT_FORMATS[components - 1];
+            case spv::OP_TYPE_INT:
+                return op[3] ? SINT_FORMATS[components - 1] : UINT_FORMATS[components - 1];
+            default:
+                return VK_FORMAT_UNDEFINED;
+        }
+    }
+};
+
+VkShaderStageFlagBits execution_stage(uint32_t model) {
+    switch (model) {
+        case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+        case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+        case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+        default: return VK_SHADER_STAGE_ALL;
+    }
+}
+
+}
+
+bool ShaderReflection::reflect(const uint32_t *code, size_t size) {
+    stage = VK_SHADER_STAGE_ALL;
+    entry_point.clear();
+    bindings.clear();
+    inputs.clear();
+    push_constant = {};
+
+    size_t word_count = size / 4;
+    if (code == nullptr || word_count < 5 || code[0] != spv::MAGIC) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Not a SPIR-V module, skipping reflection" << std::endl;
+        #endif
+        return false;
+    }
+
+    Module module;
+    uint32_t bound = code[3]; // Every id is below the bound
+    module.definitions.assign(bound, nullptr);
+    module.decorations.resize(bound);
+
+    std::vector<const uint32_t *> variables;
+
+    for (size_t i = 5; i < word_count;) {
+        const uint32_t *op = code + i;
+        uint32_t length = op[0] >> 16;
+        uint32_t opcode = op[0] & 0xFFFF;
+        if (length == 0 || i + length > word_count) {
+            #ifdef ALCHEMIST_DEBUG
+            std::cerr << "Truncated SPIR-V instruction, skipping reflection" << std::endl;
+            #endif
+            return false;
+        }
+        i += length;
+
+        switch (opcode) {
+            case spv::OP_ENTRY_POINT:
+                if (entry_point.empty() && length > 3) {
+                    stage = execution_stage(op[1]);
+                    const char *name = reinterpret_cast<const char *>(op + 3);
+                    entry_point.assign(name, strnlen(name, (length - 3) * 4));
+                }
+                break;
+            case spv::OP_DECORATE:
+                if (length >= 3 && op[1] < bound) {
+                    Decorations &decorations = module.decorations[op[1]];
+                    uint32_t value = length > 3 ? op[3] : 0;
+                    switch (op[2]) {
+                        case spv::DECORATION_DESCRIPTOR_SET: decorations.set = value; break;
+                        case spv::DECORATION_BINDING: decorations.binding = value; decorations.has_binding = true; break;
+                        case spv::DECORATION_LOCATION: decorations.location = value; decorations.has_location = true; break;
+                        case spv::DECORATION_ARRAY_STRIDE: decorations.array_stride = value; break;
+                        case spv::DECORATION_BUFFER_BLOCK: decorations.buffer_block = true; break;
+                        case spv::DECORATION_BUILT_IN: decorations.built_in = true; break;
+                        default: break;
+                    }
+                }
+                break;
+            case spv::OP_MEMBER_DECORATE:
+                if (length >= 5) {
+                    uint64_t key = (static_cast<uint64_t>(op[1]) << 32) | op[2];
+                    if (op[3] == spv::DECORATION_OFFSET) {
+                        module.member_offsets[key] = op[4];
+                    } else if (op[3] == spv::DECORATION_MATRIX_STRIDE) {
+                        module.member_matrix_strides[key] = op[4];
+                    }
+                }
+                break;
+            case spv::OP_TYPE_BOOL:
+            case spv::OP_TYPE_INT:
+            case spv::OP_TYPE_FLOAT:
+            case spv::OP_TYPE_VECTOR:
+            case spv::OP_TYPE_MATRIX:
+            case spv::OP_TYPE_IMAGE:
+            case spv::OP_TYPE_SAMPLER:
+            case spv::OP_TYPE_SAMPLED_IMAGE:
+            case spv::OP_TYPE_ARRAY:
+            case spv::OP_TYPE_RUNTIME_ARRAY:
+            case spv::OP_TYPE_STRUCT:
+            case spv::OP_TYPE_POINTER:
+                if (length >= 2 && op[1] < bound) {
+                    module.definitions[op[1]] = op; // Types define their id in the first operand
+                }
+                break;
+            case spv::OP_CONSTANT:
+                if (length >= 4 && op[2] < bound) {
+                    module.definitions[op[2]] = op;
+                }
+                break;
+            case spv::OP_VARIABLE:
+                if (length >= 4) {
+                    variables.push_back(op);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    for (const uint32_t *variable : variables) {
+        uint32_t id = variable[2];
+        uint32_t storage = variable[3];
+        const uint32_t *pointer = module.definition(variable[1]);
+        if (id >= bound || pointer == nullptr || (pointer[0] & 0xFFFF) != spv::OP_TYPE_POINTER) {
+            continue;
+        }
+        uint32_t type = pointer[3];
+        const Decorations &decorations = module.decorations[id];
+
+        if (storage == spv::STORAGE_PUSH_CONSTANT) {
+            uint32_t offset = module.first_offset(type);
+            uint32_t end = module.size_of(type);
+            push_constant.stageFlags = stage;
+            push_constant.offset = offset;
+            push_constant.size = ((end - std::min(offset, end)) + 3) & ~3u; // Ranges are multiples of 4 bytes
+            continue;
+        }
+
+        if (storage == spv::STORAGE_INPUT) {
+            if (stage != VK_SHADER_STAGE_VERTEX_BIT || decorations.built_in || !decorations.has_location) {
+                continue; // Only vertex attributes are reflected
+            }
+
+            VkFormat format = module.input_format(type);
+            if (format == VK_FORMAT_UNDEFINED) {
+                #ifdef ALCHEMIST_DEBUG
+                std::cerr << "Unsupported vertex input type at location " << decorations.location << std::endl;
+                #endif
+                continue;
+            }
+            inputs.push_back({decorations.location, format});
+            continue;
+        }
+
+        if ((storage != spv::STORAGE_UNIFORM_CONSTANT && storage != spv::STORAGE_UNIFORM && storage != spv::STORAGE_STORAGE_BUFFER) ||
+            !decorations.has_binding) {
+            continue; // Not a descriptor
+        }
+
+        uint32_t count = 1;
+        while (module.opcode(type) == spv::OP_TYPE_ARRAY || module.opcode(type) == spv::OP_TYPE_RUNTIME_ARRAY) {
+            const uint32_t *array = module.definition(type);
+            if ((array[0] & 0xFFFF) == spv::OP_TYPE_ARRAY) {
+                count *= module.constant(array[3]);
+            }
+            type = array[2];
+        }
+
+        VkDescriptorType descriptor_type = module.descriptor_type(type, storage);
+        if (descriptor_type == VK_DESCRIPTOR_TYPE_MAX_ENUM) {
+            #ifdef ALCHEMIST_DEBUG
+            std::cerr << "Unsupported descriptor at set " << decorations.set << " binding " << decorations.binding << std::endl;
+            #endif
+            continue;
+        }
+
+        bindings.push_back({decorations.set, decorations.binding, descriptor_type, count, static_cast<VkShaderStageFlags>(stage)});
+    }
+
+    std::sort(bindings.begin(), bindings.end(), [](const ReflectedBinding &a, const ReflectedBinding &b) {
+        return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+    });
+    std::sort(inputs.begin(), inputs.end(), [](const ReflectedInput &a, const ReflectedInput &b) {
+        return a.location < b.location;
+    });
+
+    return true;
+}
+
+uint32_t format_size(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R32_SFLOAT:
+        case VK_FORMAT_R32_SINT:
+        case VK_FORMAT_R32_UINT:
+            return 4;
+        case VK_FORMAT_R32G32_SFLOAT:
+        case VK_FORMAT_R32G32_SINT:
+        case VK_FORMAT_R32G32_UINT:
+            return 8;
+        case VK_FORMAT_R32G32B32_SFLOAT:
+        case VK_FORMAT_R32G32B32_SINT:
+        case VK_FORMAT_R32G32B32_UINT:
+            return 12;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+        case VK_FORMAT_R32G32B32A32_SINT:
+        case VK_FORMAT_R32G32B32A32_UINT:
+            return 16;
+        default:
+            return 0;
+    }
+}
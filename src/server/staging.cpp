@@ -0,0 +1,179 @@
+
+#ifdef ALCHEMIST_DEBUG
+#include <iostream>
+#endif // ALCHEMIST_DEBUG
+
+#include <algorithm>
+#include <bit>
+
+#include "server/staging.hpp"
+
+#include "server/gpu_memory.hpp"
+#include "memory/misc.hpp"
+
+StagingRing::StagingRing(VkDevice device, VkPhysicalDevice physical_device, VkDeviceSize capacity) : device(device), physical_device(physical_device), capacity(capacity) {}
+
+StagingRing::~StagingRing() {
+    wait_idle(); // Nothing may still read from the ring
+
+    for (const auto &[ring, memory] : retired) {
+        destroy(ring, memory);
+    }
+    destroy(buffer, memory_rid);
+}
+
+StagingRegion StagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    reclaim(); // Retire what the GPU is done with first
+
+    VkDeviceSize offset = find_space(size, alignment);
+    while (offset == VK_WHOLE_SIZE && !in_flight.empty()) {
+        in_flight.front().done.wait(); // Wait for the oldest batch
+        reclaim();
+        offset = find_space(size, alignment);
+    }
+
+    if (offset == VK_WHOLE_SIZE) {
+        // Either the first allocation or the unsealed regions fill the ring, move to a larger buffer
+        VkDeviceSize new_capacity = std::bit_ceil(std::max(size, buffer == VK_NULL_HANDLE ? capacity : capacity * 2));
+        if (buffer != VK_NULL_HANDLE) {
+            if (pending) {
+                retired.emplace_back(buffer, memory_rid); // Still read by commands that are not submitted yet
+            } else {
+                destroy(buffer, memory_rid);
+            }
+            #ifdef ALCHEMIST_DEBUG
+            std::cerr << "Staging ring full, growing to " << new_capacity << " bytes" << std::endl;
+            #endif
+        }
+
+        pending = false;
+        if (!create(new_capacity)) {
+            return {}; // Out of host visible memory
+        }
+        offset = find_space(size, alignment);
+    }
+
+    head = offset + size;
+    pending = true;
+
+    return {buffer, offset, mapped + offset};
+}
+
+void StagingRing::seal(const GpuFuture &done) {
+    if (!pending && retired.empty()) {
+        return; // Nothing to track
+    }
+
+    in_flight.push_back({done, head, buffer, std::move(retired)});
+    retired.clear();
+    pending = false;
+}
+
+void StagingRing::reclaim() {
+    while (!in_flight.empty() && in_flight.front().done.is_ready()) {
+        InFlight &batch = in_flight.front();
+        if (batch.buffer == buffer) {
+            tail = batch.end; // Everything up to the batch end is free again
+        }
+        for (const auto &[ring, memory] : batch.retired) {
+            destroy(ring, memory);
+        }
+        in_flight.pop_front();
+    }
+
+    if (!live()) {
+        head = 0;
+        tail = 0; // Empty ring, start over from the front
+    }
+}
+
+void StagingRing::wait_idle() {
+    while (!in_flight.empty()) {
+        in_flight.front().done.wait();
+        reclaim();
+    }
+}
+
+bool StagingRing::create(VkDeviceSize size) {
+    VkBufferCreateInfo buffer_info = {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT; // Staging buffer for transfer
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    buffer = VK_NULL_HANDLE;
+    memory_rid = RID_INVALID;
+    mapped = nullptr;
+    capacity = size;
+    head = 0;
+    tail = 0;
+
+    if (vkCreateBuffer(device, &buffer_info, nullptr, &buffer) != VK_SUCCESS) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to create staging ring buffer!" << std::endl;
+        #endif
+        buffer = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkMemoryRequirements mem_requirements;
+    vkGetBufferMemoryRequirements(device, buffer, &mem_requirements);
+
+    GpuMemoryServer &gpu_memory_server = GpuMemoryServer::instance();
+    memory_rid = gpu_memory_server.allocate_block<VkBuffer>(
+        mem_requirements.size,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        find_memory_type(physical_device, mem_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+    );
+    if (gpu_memory_server.bind(memory_rid, mem_requirements, buffer) == RID_INVALID) {
+        destroy(buffer, memory_rid);
+        buffer = VK_NULL_HANDLE;
+        memory_rid = RID_INVALID;
+        return false;
+    }
+
+    void *data;
+    gpu_memory_server.map(memory_rid, &data); // Stays mapped until the ring is destroyed
+    mapped = static_cast<uint8_t *>(data);
+
+    #ifdef ALCHEMIST_DEBUG
+    std::cout << "Created staging ring of " << size << " bytes" << std::endl;
+    #endif
+    return mapped != nullptr;
+}
+
+void StagingRing::destroy(VkBuffer ring, RID memory) {
+    if (ring != VK_NULL_HANDLE) {
+        vkDestroyBuffer(device, ring, nullptr);
+    }
+    if (memory != RID_INVALID) {
+        GpuMemoryServer::instance().free_block(memory); // Freeing the memory unmaps it
+    }
+}
+
+bool StagingRing::live() const {
+    return pending || (!in_flight.empty() && in_flight.back().buffer == buffer);
+}
+
+VkDeviceSize StagingRing::find_space(VkDeviceSize size, VkDeviceSize alignment) const {
+    if (buffer == VK_NULL_HANDLE) {
+        return VK_WHOLE_SIZE; // Not created yet
+    }
+
+    VkDeviceSize offset = (head + alignment - 1) & ~(alignment - 1);
+    if (!live() || head > tail) {
+        // Free space is [head, capacity) and [0, tail)
+        if (offset + size <= capacity) {
+            return offset;
+        }
+        if (live() && size <= tail) {
+            return 0; // Wrap around
+        }
+        return VK_WHOLE_SIZE;
+    }
+
+    if (head < tail && offset + size <= tail) {
+        return offset; // Free space is [head, tail)
+    }
+    return VK_WHOLE_SIZE; // head == tail on a live ring, the ring is full
+}
@@ -0,0 +1,147 @@
+
+#ifdef ALCHEMIST_DEBUG
+#include <iostream>
+#endif // ALCHEMIST_DEBUG
+
+#include "server/transfer.hpp"
+
+#include "server/buffer.hpp"
+#include "server/image.hpp"
+
+TransferServer::TransferServer(VkDevice device, RID queue, RID command_pool, uint32_t src_family, uint32_t dst_family)
+    : device(device), queue(queue), command_pool(command_pool), src_family(src_family), dst_family(dst_family) {}
+
+TransferServer::~TransferServer() {
+    wait_idle();
+    for (const auto &batch : batches) {
+        vkDestroySemaphore(device, batch.semaphore, nullptr);
+    }
+    for (const auto &batch : free_batches) {
+        vkDestroySemaphore(device, batch.semaphore, nullptr);
+    }
+    // Command buffers are freed with their pool
+}
+
+bool TransferServer::flush() {
+    BufferServer &buffer_server = BufferServer::instance();
+    ImageServer &image_server = ImageServer::instance();
+
+    if (buffer_server.command_types.empty() && image_server.command_types.empty()) {
+        return false; // Nothing to upload
+    }
+
+    collect();
+
+    TransferBatch batch;
+    if (!free_batches.empty()) {
+        batch = std::move(free_batches.back());
+        free_batches.pop_back();
+        batch.cmd_buffer.reset();
+    } else {
+        batch.cmd_buffer = allocate_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, command_pool);
+
+        VkSemaphoreCreateInfo semaphore_info = {};
+        semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        if (batch.cmd_buffer.buffer == VK_NULL_HANDLE ||
+            vkCreateSemaphore(device, &semaphore_info, nullptr, &batch.semaphore) != VK_SUCCESS) {
+            #ifdef ALCHEMIST_DEBUG
+            std::cerr << "Failed to create transfer batch!" << std::endl;
+            #endif
+            return false;
+        }
+    }
+
+    batch.buffer_acquires.clear();
+    batch.image_acquires.clear();
+    batch.consumer = VK_NULL_HANDLE;
+    batch.acquired = false;
+
+    batch.cmd_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+    buffer_server.execute_commands(batch.cmd_buffer.buffer);
+    image_server.execute_commands(batch.cmd_buffer.buffer);
+
+    if (src_family != dst_family) {
+        std::vector<VkBufferMemoryBarrier> buffer_releases;
+        std::vector<VkImageMemoryBarrier> image_releases;
+        buffer_server.ownership_barriers(src_family, dst_family, buffer_releases, batch.buffer_acquires);
+        image_server.ownership_barriers(src_family, dst_family, image_releases, batch.image_acquires);
+
+        vkCmdPipelineBarrier(
+            batch.cmd_buffer.buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0, // No flags
+            0, nullptr, // No memory barriers
+            static_cast<uint32_t>(buffer_releases.size()), buffer_releases.data(), // Release the buffers
+            static_cast<uint32_t>(image_releases.size()), image_releases.data() // Release the images
+        );
+    }
+
+    batch.cmd_buffer.end();
+
+    batch.done = QueueServer::instance().get_queue(queue).submit()
+        .add_command_buffer(batch.cmd_buffer)
+        .add_signal_semaphore(batch.semaphore)
+        .submit();
+
+    buffer_server.staging.seal(batch.done); // The staging regions are free again once the copies are done
+    image_server.staging.seal(batch.done);
+
+    buffer_server.clear_commands(); // Recorded, the staging regions are tracked by the rings
+    image_server.clear_commands();
+
+    batches.push_back(std::move(batch));
+    return true;
+}
+
+void TransferServer::acquire(VkCommandBuffer cmd_buffer, SubmitBuilder &submit, VkFence frame_fence) {
+    for (auto &batch : batches) {
+        if (batch.acquired) {
+            continue; // Already consumed by an earlier frame
+        }
+
+        if (!batch.buffer_acquires.empty() || !batch.image_acquires.empty()) {
+            vkCmdPipelineBarrier(
+                cmd_buffer,
+                CONSUMER_STAGES, // Chained with the semaphore wait
+                CONSUMER_STAGES,
+                0, // No flags
+                0, nullptr, // No memory barriers
+                static_cast<uint32_t>(batch.buffer_acquires.size()), batch.buffer_acquires.data(), // Acquire the buffers
+                static_cast<uint32_t>(batch.image_acquires.size()), batch.image_acquires.data() // Acquire the images
+            );
+        }
+
+        submit.add_wait_semaphore(batch.semaphore, CONSUMER_STAGES); // Rendering only stalls where uploaded data is read
+        batch.consumer = frame_fence;
+        batch.acquired = true;
+    }
+}
+
+void TransferServer::collect() {
+    while (!batches.empty()) {
+        TransferBatch &batch = batches.front();
+        if (!batch.acquired ||
+            !batch.done.is_ready() ||
+            (batch.consumer != VK_NULL_HANDLE && vkGetFenceStatus(device, batch.consumer) != VK_SUCCESS)) {
+            break; // The semaphore is still in use
+        }
+
+        free_batches.push_back(std::move(batch));
+        batches.pop_front();
+    }
+}
+
+void TransferServer::wait_idle() {
+    for (const auto &batch : batches) {
+        batch.done.wait();
+    }
+}
+
+TransferServer &TransferServer::instance() {
+    return *__instance; // Return the singleton instance of TransferServer
+}
+
+std::unique_ptr<TransferServer> TransferServer::__instance = nullptr; // Singleton instance of TransferServer
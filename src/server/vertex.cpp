@@ -0,0 +1,64 @@
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "server/vertex.hpp"
+
+uint16_t encode_half(float value) {
+    uint32_t bits = std::bit_cast<uint32_t>(value);
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t exponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (exponent == 0xFF) {
+        return static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0)); // Infinity or NaN
+    }
+
+    int32_t half_exponent = static_cast<int32_t>(exponent) - 127 + 15;
+    if (half_exponent >= 31) {
+        return static_cast<uint16_t>(sign | 0x7C00); // Too large, infinity
+    }
+
+    if (half_exponent <= 0) {
+        if (half_exponent < -10) {
+            return static_cast<uint16_t>(sign); // Too small even for a subnormal
+        }
+        mantissa |= 0x800000; // Implicit leading bit
+        uint32_t shift = static_cast<uint32_t>(14 - half_exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) {
+            half++; // May carry into the smallest normal, which is the right result
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    uint32_t half = sign | (static_cast<uint32_t>(half_exponent) << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+        half++; // A carry out of the mantissa bumps the exponent, up to infinity
+    }
+    return static_cast<uint16_t>(half);
+}
+
+half2 encode_half2(const vec2 &value) {
+    return {encode_half(value.x), encode_half(value.y)};
+}
+
+half4 encode_half4(const vec3 &value, float w) {
+    return {encode_half(value.x), encode_half(value.y), encode_half(value.z), encode_half(w)};
+}
+
+static uint8_t encode_unorm8_channel(float value) {
+    return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+
+unorm8x4 encode_unorm8(const vec3 &color, float alpha) {
+    return {encode_unorm8_channel(color.x), encode_unorm8_channel(color.y), encode_unorm8_channel(color.z), encode_unorm8_channel(alpha)};
+}
+
+QuantizedPositionColorVertex quantize(const PositionColorVertex &vertex) {
+    return {encode_half4(vertex.position), encode_unorm8(vertex.color)};
+}
@@ -0,0 +1,106 @@
+
+#ifdef ALCHEMIST_DEBUG
+#include <iostream> // Include for debug output
+#endif // ALCHEMIST_DEBUG
+
+#include "vulkan/parallel_recorder.hpp"
+
+#include "server/command_pool.hpp"
+#include "server/render_pass.hpp"
+#include "server/framebuffer.hpp"
+
+ParallelRecorder::ParallelRecorder(uint32_t frames_in_flight, uint32_t queue_family_index, uint32_t thread_count)
+    : workers(thread_count) {
+    frames.resize(frames_in_flight);
+    for (auto &threads : frames) {
+        threads.resize(workers.size());
+        for (RID &pool : threads) {
+            pool = CommandPoolServer::instance().new_command_pool()
+                .set_flags(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT) // Buffers are only reset with their pool
+                .set_queue_family_index(queue_family_index)
+                .build();
+        }
+    }
+}
+
+void ParallelRecorder::begin_frame(uint32_t flight_frame) {
+    frame = flight_frame;
+
+    for (RID pool : frames[frame]) {
+        CommandPoolServer::instance().reset_command_pool(pool); // Every secondary buffer of the thread at once
+    }
+}
+
+void ParallelRecorder::record(CommandRecorder &primary, RID render_pass, RID framebuffer, uint32_t subpass, uint32_t job_count, const Job &job) {
+    if (job_count == 0) {
+        return;
+    }
+
+    const std::vector<RID> &threads = frames[frame];
+    uint32_t thread_total = static_cast<uint32_t>(threads.size());
+
+    job_stats.assign(job_count, {});
+    secondaries.resize(job_count);
+
+    // Acquire on this thread, the workers only record into buffers they already own
+    for (uint32_t index = 0; index < job_count; ++index) {
+        secondaries[index] = CommandPoolServer::instance().acquire_command_buffer(threads[index % thread_total], VK_COMMAND_BUFFER_LEVEL_SECONDARY).buffer;
+    }
+
+    VkCommandBufferInheritanceInfo inheritance = {};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.renderPass = RenderPassServer::instance().get_render_pass(render_pass).render_pass;
+    inheritance.subpass = subpass;
+    inheritance.framebuffer = FramebufferServer::instance().get_framebuffer(framebuffer).framebuffer;
+
+    // Thread t takes jobs t, t + T, t + 2T... so each pool stays on a single thread
+    for (uint32_t thread = 0; thread < thread_total && thread < job_count; ++thread) {
+        workers.submit([this, &inheritance, &job, thread, thread_total, job_count]() {
+            for (uint32_t index = thread; index < job_count; index += thread_total) {
+                VkCommandBuffer buffer = secondaries[index];
+
+                VkCommandBufferBeginInfo begin_info = {};
+                begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+                begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+                begin_info.pInheritanceInfo = &inheritance;
+
+                if (buffer == VK_NULL_HANDLE || vkBeginCommandBuffer(buffer, &begin_info) != VK_SUCCESS) {
+                    #ifdef ALCHEMIST_DEBUG
+                    std::cerr << "Failed to begin secondary command buffer!" << std::endl;
+                    #endif
+                    secondaries[index] = VK_NULL_HANDLE;
+                    continue;
+                }
+
+                CommandRecorder recorder;
+                recorder.begin(buffer);
+                job(recorder, index);
+
+                vkEndCommandBuffer(buffer);
+                job_stats[index] = recorder.stats;
+            }
+        });
+    }
+
+    workers.wait_idle();
+
+    // Drop the buffers that failed to begin, keep the job order of the others, they still go back with their pool
+    uint32_t count = 0;
+    for (uint32_t index = 0; index < job_count; ++index) {
+        primary.stats.emitted += job_stats[index].emitted;
+        primary.stats.skipped += job_stats[index].skipped;
+        if (secondaries[index] != VK_NULL_HANDLE) {
+            secondaries[count++] = secondaries[index];
+        }
+    }
+
+    if (count > 0) {
+        vkCmdExecuteCommands(primary.buffer, count, secondaries.data());
+        primary.stats.emitted++;
+    }
+    primary.invalidate(); // The primary state is undefined after executing secondary buffers
+}
+
+uint32_t ParallelRecorder::thread_count() const {
+    return workers.size();
+}
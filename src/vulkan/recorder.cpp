@@ -0,0 +1,219 @@
+
+#ifdef ALCHEMIST_DEBUG
+#include <iostream> // Include for debug output
+#endif // ALCHEMIST_DEBUG
+
+#include <algorithm>
+#include <cstring>
+
+#include "vulkan/recorder.hpp"
+
+#include "server/pipeline.hpp"
+#include "server/descriptor.hpp"
+#include "server/mesh.hpp"
+
+CommandRecorder::CommandRecorder(VkCommandBuffer buffer) : buffer(buffer) {}
+
+void CommandRecorder::begin(VkCommandBuffer buffer) {
+    this->buffer = buffer;
+    invalidate(); // A new command buffer starts with no state bound
+    stats = {};
+}
+
+void CommandRecorder::invalidate() {
+    graphics = {};
+    compute = {};
+    vertex_buffers.fill(VK_NULL_HANDLE);
+    vertex_offsets.fill(0);
+    index_buffer = VK_NULL_HANDLE;
+    index_offset = 0;
+    index_type = VK_INDEX_TYPE_MAX_ENUM;
+    has_viewport = false;
+    has_scissor = false;
+}
+
+CommandRecorder::BindPointState &CommandRecorder::state(VkPipelineBindPoint bind_point) {
+    return bind_point == VK_PIPELINE_BIND_POINT_COMPUTE ? compute : graphics;
+}
+
+void CommandRecorder::bind_pipeline(RID pipeline, VkPipelineBindPoint bind_point) {
+    const Pipeline &pipe = PipelineServer::instance().get_pipeline(pipeline);
+    if (pipe.pipeline == VK_NULL_HANDLE) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Invalid pipeline RID: " << pipeline << std::endl;
+        #endif
+        return; // Return without binding if the RID is invalid
+    }
+
+    BindPointState &bound = state(bind_point);
+    if (bound.pipeline == pipe.pipeline) {
+        stats.skipped++;
+        return;
+    }
+
+    vkCmdBindPipeline(buffer, bind_point, pipe.pipeline);
+    bound.pipeline = pipe.pipeline;
+    stats.emitted++;
+}
+
+void CommandRecorder::bind_descriptor_set(RID pipeline_layout, RID descriptor_set, VkPipelineBindPoint bind_point,
+    uint32_t first_set, const uint32_t *offsets, uint32_t offset_count) {
+    const PipelineLayout &layout = PipelineLayoutServer::instance().get_pipeline_layout(pipeline_layout);
+    if (layout.layout == VK_NULL_HANDLE) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Invalid pipeline layout RID: " << pipeline_layout << std::endl;
+        #endif
+        return; // Return without binding if the RID is invalid
+    }
+
+    const Descriptor &set = DescriptorServer::instance().get_descriptor(descriptor_set);
+    if (set.descriptor_set == VK_NULL_HANDLE) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Invalid descriptor set RID: " << descriptor_set << std::endl;
+        #endif
+        return; // Return without binding if the RID is invalid
+    }
+
+    BindPointState &bound = state(bind_point);
+    bool tracked = first_set < MAX_BOUND_SETS && offset_count <= MAX_DYNAMIC_OFFSETS;
+
+    if (tracked && bound.layout == layout.layout) {
+        const BoundSet &current = bound.sets[first_set];
+        if (current.set == set.descriptor_set && current.offset_count == offset_count &&
+            std::equal(offsets, offsets + offset_count, current.offsets.begin())) {
+            stats.skipped++;
+            return;
+        }
+    }
+
+    vkCmdBindDescriptorSets(buffer, bind_point, layout.layout, first_set, 1, &set.descriptor_set, offset_count, offsets);
+    stats.emitted++;
+
+    if (bound.layout != layout.layout) {
+        bound.sets = {}; // Sets bound with another layout may have been disturbed, stop trusting them
+        bound.layout = layout.layout;
+    }
+
+    if (!tracked) {
+        if (first_set < MAX_BOUND_SETS) {
+            bound.sets[first_set] = {}; // Too many offsets to remember, always rebind this set
+        }
+        return;
+    }
+
+    BoundSet &current = bound.sets[first_set];
+    current.set = set.descriptor_set;
+    current.offset_count = offset_count;
+    std::copy(offsets, offsets + offset_count, current.offsets.begin());
+}
+
+void CommandRecorder::bind_vertex_buffers(uint32_t first_binding, uint32_t count, const VkBuffer *buffers, const VkDeviceSize *offsets) {
+    if (count == 0) {
+        return;
+    }
+
+    if (first_binding + count > MAX_VERTEX_BINDINGS) {
+        vkCmdBindVertexBuffers(buffer, first_binding, count, buffers, offsets); // Out of the tracked range, emit as is
+        stats.emitted++;
+        return;
+    }
+
+    // Trim the bindings that are already bound at both ends, the middle is emitted in one call
+    uint32_t begin = 0;
+    while (begin < count && vertex_buffers[first_binding + begin] == buffers[begin] && vertex_offsets[first_binding + begin] == offsets[begin]) {
+        begin++;
+    }
+    if (begin == count) {
+        stats.skipped++;
+        return;
+    }
+
+    uint32_t end = count;
+    while (end > begin && vertex_buffers[first_binding + end - 1] == buffers[end - 1] && vertex_offsets[first_binding + end - 1] == offsets[end - 1]) {
+        end--;
+    }
+
+    vkCmdBindVertexBuffers(buffer, first_binding + begin, end - begin, buffers + begin, offsets + begin);
+    stats.emitted++;
+
+    std::copy(buffers + begin, buffers + end, vertex_buffers.begin() + first_binding + begin);
+    std::copy(offsets + begin, offsets + end, vertex_offsets.begin() + first_binding + begin);
+}
+
+void CommandRecorder::bind_index_buffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType type) {
+    if (index_buffer == buffer && index_offset == offset && index_type == type) {
+        stats.skipped++;
+        return;
+    }
+
+    vkCmdBindIndexBuffer(this->buffer, buffer, offset, type);
+    index_buffer = buffer;
+    index_offset = offset;
+    index_type = type;
+    stats.emitted++;
+}
+
+void CommandRecorder::bind_mesh(const Mesh &mesh) {
+    if (mesh.handle == VK_NULL_HANDLE) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Mesh with RID " << mesh.rid << " has no valid buffer!" << std::endl;
+        #endif
+        return; // If the buffer is invalid, do not bind
+    }
+
+    if (mesh.index_type != VK_INDEX_TYPE_MAX_ENUM) {
+        bind_index_buffer(mesh.handle, mesh.index_offset, mesh.index_type);
+    }
+    bind_vertex_buffers(0, std::min(mesh.binding_count, MAX_VERTEX_BINDINGS), mesh.vertex_buffers.data(), mesh.vertex_offsets.data());
+}
+
+void CommandRecorder::viewport(VkExtent2D extent) {
+    VkViewport viewport = {};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    this->viewport(viewport);
+}
+
+void CommandRecorder::viewport(const VkViewport &viewport) {
+    if (has_viewport && std::memcmp(&bound_viewport, &viewport, sizeof(VkViewport)) == 0) {
+        stats.skipped++;
+        return;
+    }
+
+    vkCmdSetViewport(buffer, 0, 1, &viewport);
+    bound_viewport = viewport;
+    has_viewport = true;
+    stats.emitted++;
+}
+
+void CommandRecorder::scissor(VkRect2D rect) {
+    if (has_scissor && std::memcmp(&bound_scissor, &rect, sizeof(VkRect2D)) == 0) {
+        stats.skipped++;
+        return;
+    }
+
+    vkCmdSetScissor(buffer, 0, 1, &rect);
+    bound_scissor = rect;
+    has_scissor = true;
+    stats.emitted++;
+}
+
+void CommandRecorder::draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance) {
+    vkCmdDraw(buffer, vertex_count, instance_count, first_vertex, first_instance);
+    stats.emitted++;
+}
+
+void CommandRecorder::draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance) {
+    vkCmdDrawIndexed(buffer, index_count, instance_count, first_index, vertex_offset, first_instance);
+    stats.emitted++;
+}
+
+void CommandRecorder::dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z) {
+    vkCmdDispatch(buffer, group_count_x, group_count_y, group_count_z);
+    stats.emitted++;
+}
@@ -3,6 +3,7 @@
 
 #include "server/pipeline.hpp"
 #include "server/descriptor.hpp"
+#include "server/buffer.hpp"
 #include <iostream>
 
 void bind_pipeline(VkCommandBuffer cmd_buffer, RID pipeline, VkPipelineBindPoint bind_point) {
@@ -42,6 +43,22 @@ void scissor(VkCommandBuffer cmd_buffer, VkRect2D rect) {
     vkCmdSetScissor(cmd_buffer, 0, 1, &scissor); // Set the scissor rectangle for the command buffer
 }
 
+void dispatch(VkCommandBuffer cmd_buffer, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z) {
+    vkCmdDispatch(cmd_buffer, group_count_x, group_count_y, group_count_z); // Run the bound compute pipeline
+}
+
+void dispatch_indirect(VkCommandBuffer cmd_buffer, RID buffer, VkDeviceSize offset) {
+    const Buffer &buf = BufferServer::instance().get_buffer(buffer);
+    if (buf.buffer == VK_NULL_HANDLE) {
+#ifdef ALCHEMIST_DEBUG
+        std::cerr << "Invalid indirect buffer RID: " << buffer << std::endl;
+#endif
+        return; // Return without dispatching if the RID is invalid
+    }
+
+    vkCmdDispatchIndirect(cmd_buffer, buf.buffer, offset); // Group counts written by the GPU, no readback
+}
+
 void bind_descriptor_sets(VkCommandBuffer cmd_buffer, RID pipeline_layout, RID descriptor_set, VkPipelineBindPoint bind_point, uint32_t *offset) {
     const PipelineLayoutServer &pipeline_server = PipelineLayoutServer::instance();
     const PipelineLayout &layout = pipeline_server.get_pipeline_layout(pipeline_layout);
@@ -0,0 +1,121 @@
+
+#ifdef ALCHEMIST_DEBUG
+#include <iostream> // Include for debug output
+#endif // ALCHEMIST_DEBUG
+
+#include <algorithm>
+#include <bit>
+
+#include "vulkan/render_queue.hpp"
+
+#include "server/mesh.hpp"
+
+static uint32_t depth_bits(float depth) {
+    // Positive floats compare like their bit patterns, no conversion to fixed point needed
+    return std::bit_cast<uint32_t>(std::max(depth, 0.0f));
+}
+
+uint64_t RenderQueue::make_key(const DrawPacket &packet, uint8_t pass, RenderLayer layer) {
+    uint64_t key = (static_cast<uint64_t>(pass & 0xF) << 60) | (static_cast<uint64_t>(layer & 0x3) << 58);
+
+    // Slot indices stand in for the resources, a collision only costs a redundant state change
+    uint64_t pipeline = rid_index(packet.pipeline) & 0xFFFF;
+    uint64_t set = packet.descriptor_set == RID_INVALID ? 0 : rid_index(packet.descriptor_set) + 1;
+    uint64_t mesh = packet.mesh == RID_INVALID ? 0 : rid_index(MeshServer::instance().get_mesh(packet.mesh).buffer) & 0xFFF; // Meshes sharing an arena chunk sort together
+
+    if (layer == RENDER_LAYER_TRANSPARENT) {
+        uint64_t depth = ~depth_bits(packet.depth); // Farthest first, blending needs it
+        return key | (depth << 26) | (pipeline << 10) | (set & 0x3FF);
+    }
+
+    uint64_t depth = depth_bits(packet.depth) >> 16; // Front to back inside a state bucket, for early depth rejection
+    return key | (pipeline << 42) | ((set & 0x3FFF) << 28) | (mesh << 16) | depth;
+}
+
+void RenderQueue::clear() {
+    packets.clear();
+    entries.clear();
+}
+
+void RenderQueue::push(const DrawPacket &packet, uint8_t pass, RenderLayer layer) {
+    if (pass >= MAX_PASSES) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Render pass index " << static_cast<uint32_t>(pass) << " out of range, draw dropped" << std::endl;
+        #endif
+        return;
+    }
+
+    entries.push_back({make_key(packet, pass, layer), static_cast<uint32_t>(packets.size())});
+    packets.push_back(packet);
+}
+
+void RenderQueue::sort() {
+    // LSD radix sort on bytes, stable so equal keys keep their push order
+    scratch.resize(entries.size());
+
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        std::array<uint32_t, 256> histogram = {};
+        for (const SortEntry &entry : entries) {
+            histogram[(entry.key >> shift) & 0xFF]++;
+        }
+        if (histogram[(entries.empty() ? 0 : entries.front().key >> shift) & 0xFF] == entries.size()) {
+            continue; // Every key shares this byte, the pass would not move anything
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t &count : histogram) {
+            uint32_t bucket = count;
+            count = offset;
+            offset += bucket;
+        }
+        for (const SortEntry &entry : entries) {
+            scratch[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+        }
+        entries.swap(scratch);
+    }
+}
+
+std::pair<uint32_t, uint32_t> RenderQueue::pass_range(uint8_t pass) const {
+    uint64_t pass_key = static_cast<uint64_t>(pass & 0xF) << 60;
+    auto begin = std::lower_bound(entries.begin(), entries.end(), pass_key, [](const SortEntry &entry, uint64_t key) {
+        return entry.key < key;
+    });
+    auto end = std::find_if(begin, entries.end(), [pass_key](const SortEntry &entry) {
+        return (entry.key >> 60) != (pass_key >> 60);
+    });
+    return {static_cast<uint32_t>(begin - entries.begin()), static_cast<uint32_t>(end - entries.begin())};
+}
+
+void RenderQueue::record(CommandRecorder &recorder, uint8_t pass) const {
+    auto [first, last] = pass_range(pass);
+    record(recorder, first, last);
+}
+
+void RenderQueue::record(CommandRecorder &recorder, uint32_t first, uint32_t last) const {
+    const MeshServer &mesh_server = MeshServer::instance();
+
+    for (uint32_t i = first; i < last; ++i) {
+        const DrawPacket &packet = packets[entries[i].packet];
+
+        recorder.bind_pipeline(packet.pipeline);
+        if (packet.descriptor_set != RID_INVALID) {
+            recorder.bind_descriptor_set(packet.layout, packet.descriptor_set, VK_PIPELINE_BIND_POINT_GRAPHICS, 0,
+                packet.offsets.data(), packet.offset_count);
+        }
+        uint32_t draw_first = packet.first;
+        int32_t vertex_offset = packet.vertex_offset;
+        if (packet.mesh != RID_INVALID) {
+            const Mesh &mesh = mesh_server.get_mesh(packet.mesh);
+            recorder.bind_mesh(mesh);
+
+            draw_first += packet.indexed ? mesh.first_index : mesh.first_vertex; // Ranges are relative to the mesh, which may sit in an arena
+            vertex_offset += mesh.vertex_offset;
+        }
+
+        if (packet.indexed) {
+            recorder.draw_indexed(packet.count, packet.instance_count, draw_first, vertex_offset);
+        } else {
+            recorder.draw(packet.count, packet.instance_count, draw_first);
+        }
+    }
+}
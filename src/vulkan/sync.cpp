@@ -85,6 +85,47 @@ uint32_t Fence::is_signaled() const {
 
 
 
+bool GpuFuture::valid() const {
+    return semaphore != VK_NULL_HANDLE;
+}
+
+bool GpuFuture::is_ready() const {
+    if (!valid()) {
+        return true; // Nothing was submitted, nothing to wait for
+    }
+
+    uint64_t counter = 0;
+    if (vkGetSemaphoreCounterValue(device, semaphore, &counter) != VK_SUCCESS) {
+        #ifdef ALCHEMIST_DEBUG
+        std::cerr << "Failed to read timeline semaphore!" << std::endl;
+        #endif
+        return false;
+    }
+    return counter >= value;
+}
+
+bool GpuFuture::wait(uint64_t timeout) const {
+    if (!valid()) {
+        return true; // Nothing was submitted, nothing to wait for
+    }
+
+    VkSemaphoreWaitInfo wait_info{};
+    wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    wait_info.semaphoreCount = 1;
+    wait_info.pSemaphores = &semaphore;
+    wait_info.pValues = &value; // Wait for this submission only
+
+    VkResult result = vkWaitSemaphores(device, &wait_info, timeout);
+    #ifdef ALCHEMIST_DEBUG
+    if (result != VK_SUCCESS && result != VK_TIMEOUT) {
+        std::cerr << "Failed to wait for timeline semaphore!" << std::endl;
+    }
+    #endif
+    return result == VK_SUCCESS;
+}
+
+
+
 SemaphoreBuilder::SemaphoreBuilder(VkDevice device) : device(device) {
     create_info = {};
     create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;